@@ -0,0 +1,202 @@
+/*
+File: Cache.c
+Programmer: Harrison Miller
+Description: bounded string-to-string cache.  Entries are found through a
+chained hash table keyed by a 64-bit hash (keys are still compared in full),
+and evicted with the CLOCK algorithm: every hit sets an entry's referenced bit,
+and the clock hand sweeps the entries clearing bits until it finds one that
+has not been used since it last passed.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include "Cache.h"
+
+// Print message to stderr and exit.
+#define DIE(msg) exit (fprintf (stderr, "%s\n", msg));
+
+typedef struct entry {
+	struct entry *chain;	/* next entry in the same bucket */
+	uint64_t hash;		/* hash of the key */
+	size_t keyLen;
+	size_t valLen;
+	bool referenced;	/* used since the clock hand last passed */
+	char data[];		/* the key followed by the value */
+} Entry;
+
+struct cache {
+	Entry **buckets;	/* hash chains */
+	size_t mask;		/* number of buckets - 1 (a power of 2) */
+	Entry **ring;		/* every entry, in the order the clock hand visits them */
+	size_t numEntries;
+	size_t ringCap;		/* slots allocated in ring */
+	size_t hand;		/* index in ring of the next entry to consider evicting */
+	size_t bytes;		/* storage charged to the entries */
+	size_t budget;		/* most storage the entries may use */
+	long hits;
+	long misses;
+};
+
+/*
+ * hash64: hash N bytes of S eight at a time
+ */
+static uint64_t hash64(const char *s, size_t n)
+{
+    const uint64_t k = 0x9e3779b97f4a7c15ULL;
+    uint64_t h = n * k;
+    uint64_t w;
+
+    for (; n >= 8; s += 8, n -= 8) {
+        memcpy(&w, s, 8);
+        h = (h ^ w) * k;
+        h ^= h >> 29;
+    }
+    w = 0;
+    memcpy(&w, s, n);
+    h = (h ^ w) * k;
+
+    // finish with the MurmurHash3 mixer so every input bit affects the bucket
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+}
+
+/*
+ * entrySize: storage charged to an entry, including its ring and bucket pointers
+ */
+static size_t entrySize(size_t keyLen, size_t valLen)
+{
+    return sizeof(Entry) + keyLen + valLen + 2 * sizeof(Entry*);
+}
+
+Cache createCache(size_t budget)
+{
+    Cache c = malloc(sizeof(*c));
+
+    if (!c)
+        DIE("malloc() failed");
+    c->mask = 1023;
+    if (!(c->buckets = calloc(c->mask + 1, sizeof(Entry*))))
+        DIE("calloc() failed");
+    c->ring = NULL;
+    c->numEntries = c->ringCap = c->hand = 0;
+    c->bytes = 0;
+    c->budget = budget;
+    c->hits = c->misses = 0;
+    return c;
+}
+
+bool lookupCache(Cache c, const char *s, size_t n, const char **val, size_t *valLen)
+{
+    uint64_t h = hash64(s, n);
+
+    for (Entry *e = c->buckets[h & c->mask]; e; e = e->chain) {
+        if (e->hash == h && e->keyLen == n && memcmp(e->data, s, n) == 0) {
+            e->referenced = true;
+            *val = e->data + n;
+            *valLen = e->valLen;
+            c->hits++;
+            return true;
+        }
+    }
+    c->misses++;
+    return false;
+}
+
+/*
+ * evict: remove the first entry the clock hand finds unreferenced
+ */
+static void evict(Cache c)
+{
+    Entry *e, **p;
+
+    while (c->ring[c->hand]->referenced) {
+        c->ring[c->hand]->referenced = false;
+        if (++c->hand == c->numEntries)
+            c->hand = 0;
+    }
+    e = c->ring[c->hand];
+
+    for (p = &c->buckets[e->hash & c->mask]; *p != e; p = &(*p)->chain)
+        ;
+    *p = e->chain;
+
+    // fill the hole with the last entry; the hand then looks at it next
+    c->ring[c->hand] = c->ring[--c->numEntries];
+    if (c->hand == c->numEntries)
+        c->hand = 0;
+    c->bytes -= entrySize(e->keyLen, e->valLen);
+    free(e);
+}
+
+/*
+ * grow: double the number of buckets and rehash the entries
+ */
+static void grow(Cache c)
+{
+    size_t mask = 2 * c->mask + 1;
+    Entry **buckets = calloc(mask + 1, sizeof(Entry*));
+
+    if (!buckets)
+        DIE("calloc() failed");
+    for (size_t i = 0; i < c->numEntries; i++) {
+        Entry *e = c->ring[i];
+        e->chain = buckets[e->hash & mask];
+        buckets[e->hash & mask] = e;
+    }
+    free(c->buckets);
+    c->buckets = buckets;
+    c->mask = mask;
+}
+
+void insertCache(Cache c, const char *s, size_t n, const char *val, size_t valLen)
+{
+    size_t size = entrySize(n, valLen);
+    Entry *e;
+
+    if (size > c->budget)
+        return;
+    while (c->bytes + size > c->budget)
+        evict(c);
+
+    if (!(e = malloc(sizeof(Entry) + n + valLen)))
+        DIE("malloc() failed");
+    e->hash = hash64(s, n);
+    e->keyLen = n;
+    e->valLen = valLen;
+    e->referenced = false;
+    memcpy(e->data, s, n);
+    memcpy(e->data + n, val, valLen);
+
+    if (c->numEntries == c->ringCap) {
+        c->ringCap = c->ringCap ? 2 * c->ringCap : 1024;
+        if (!(c->ring = realloc(c->ring, c->ringCap * sizeof(Entry*))))
+            DIE("realloc() failed");
+    }
+    c->ring[c->numEntries++] = e;
+    c->bytes += size;
+    e->chain = c->buckets[e->hash & c->mask];
+    c->buckets[e->hash & c->mask] = e;
+    if (c->numEntries > c->mask + 1)
+        grow(c);
+}
+
+void statsCache(Cache c, long *hits, long *misses)
+{
+    *hits += c->hits;
+    *misses += c->misses;
+}
+
+void destroyCache(Cache c)
+{
+    for (size_t i = 0; i < c->numEntries; i++)
+        free(c->ring[i]);
+    free(c->ring);
+    free(c->buckets);
+    free(c);
+}
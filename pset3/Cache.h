@@ -0,0 +1,34 @@
+/*
+ * File: Cache.h
+ * Programmer: Harrison Miller
+ * Description: interface to a bounded cache from strings to strings, used by
+ * Subst16 to remember the output for input lines it has already filtered.
+ */
+
+#ifndef CACHE_H
+#define CACHE_H
+
+#include <stddef.h>
+#include <stdbool.h>
+
+typedef struct cache *Cache;
+
+// Return a new, empty cache that holds at most about BUDGET bytes.
+Cache createCache(size_t budget);
+
+// Look up the key S of length N.  If it is present, set *VAL and *VALLEN to
+// the stored value (valid until the next insertCache()) and return true.
+bool lookupCache(Cache c, const char *s, size_t n, const char **val, size_t *valLen);
+
+// Store the value VAL of length VALLEN under the key S of length N, evicting
+// entries that have not been used recently to stay within the budget.
+void insertCache(Cache c, const char *s, size_t n, const char *val, size_t valLen);
+
+// Add the cache's hit and miss counts to *HITS and *MISSES.
+void statsCache(Cache c, long *hits, long *misses);
+
+// Free all storage used by the cache.
+void destroyCache(Cache c);
+
+#endif
+/* end CACHE_H */
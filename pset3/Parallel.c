@@ -0,0 +1,204 @@
+/*
+File: Parallel.c
+Programmer: Harrison Miller
+Description: multi-threaded line processing for Subst16.  The main thread reads
+stdin into batches of lines, worker threads run the rules on whole batches, and
+a writer thread prints the batches in the order they were read, so the output
+is identical to processing the lines one at a time.
+*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include "Subst16.h"
+
+/*
+ * Batch: a group of consecutive input lines and their filtered output.
+ * Batch number n lives in slot n % numSlots; the slots (and their buffers)
+ * are reused, so a run in steady state allocates nothing.
+ */
+typedef struct batch {
+	Buffer in;	/* the lines read, each followed by '\n' */
+	Buffer out;	/* the filtered lines, each followed by '\n' */
+	bool done;	/* true once a worker has filled out */
+} Batch;
+
+typedef struct pipeline {
+	pthread_mutex_t lock;
+	pthread_cond_t changed;	/* signalled whenever a count or done flag changes */
+	Batch *slots;
+	int numSlots;
+	long numRead;		/* batches filled by the reader */
+	long numTaken;		/* batches claimed by workers */
+	long numWritten;	/* batches written */
+	bool eof;		/* true once the reader is finished */
+	const Program *prog;	/* the rules */
+} Pipeline;
+
+/* what a worker thread is started with */
+typedef struct task {
+	Pipeline *pipeline;
+	Worker *worker;		/* the thread's own buffers and cache */
+} Task;
+
+/*
+ * filterBatch: run the rules on each line of a batch
+ * p: the pipeline
+ * b: the batch
+ * w: the worker's own state
+ */
+static void filterBatch(Pipeline *p, Batch *b, Worker *w)
+{
+    char *s = b->in.data;
+    char *end = b->in.data + b->in.len;
+    char *nl;
+
+    b->out.len = 0;
+    for (; s < end; s = nl + 1) {
+        nl = memchr(s, '\n', end - s);
+        w->cur.len = 0;
+        append(&w->cur, s, nl - s);
+        w->cur.data[w->cur.len] = '\0';
+        filterLine(p->prog, w);
+        append(&b->out, w->cur.data, w->cur.len);
+        append(&b->out, "\n", 1);
+    }
+}
+
+/*
+ * worker: claim batches in order and filter them until the input runs out
+ */
+static void *worker(void *arg)
+{
+    Pipeline *p = ((Task*)arg)->pipeline;
+    Worker *w = ((Task*)arg)->worker;
+    Batch *b;
+
+    pthread_mutex_lock(&p->lock);
+    for (;;) {
+        while (p->numTaken == p->numRead && !p->eof)
+            pthread_cond_wait(&p->changed, &p->lock);
+        if (p->numTaken == p->numRead)
+            break;
+        b = &p->slots[p->numTaken++ % p->numSlots];
+        pthread_mutex_unlock(&p->lock);
+
+        filterBatch(p, b, w);
+
+        pthread_mutex_lock(&p->lock);
+        b->done = true;
+        pthread_cond_broadcast(&p->changed);
+    }
+    pthread_mutex_unlock(&p->lock);
+    return NULL;
+}
+
+/*
+ * writer: write the filtered batches in the order they were read
+ */
+static void *writer(void *arg)
+{
+    Pipeline *p = arg;
+    Batch *b;
+
+    pthread_mutex_lock(&p->lock);
+    for (;;) {
+        b = &p->slots[p->numWritten % p->numSlots];
+        while (!(p->numWritten < p->numRead && b->done) && !(p->eof && p->numWritten == p->numRead))
+            pthread_cond_wait(&p->changed, &p->lock);
+        if (p->numWritten == p->numRead)
+            break;
+        pthread_mutex_unlock(&p->lock);
+
+        fwrite(b->out.data, 1, b->out.len, stdout);
+
+        pthread_mutex_lock(&p->lock);
+        b->done = false;
+        p->numWritten++;
+        pthread_cond_broadcast(&p->changed);
+    }
+    pthread_mutex_unlock(&p->lock);
+    return NULL;
+}
+
+/*
+ * runParallel: filter stdin to stdout using several threads
+ * prog: the linked rule program
+ * workers: state for each worker thread
+ * numThreads: number of worker threads
+ * batchSize: number of lines per batch
+ */
+void runParallel(const Program *prog, Worker workers[], int numThreads, int batchSize)
+{
+    Pipeline p;
+    Task *tasks = malloc(numThreads * sizeof(Task));
+    pthread_t *threads = malloc(numThreads * sizeof(pthread_t));
+    pthread_t out;
+    Buffer line = {NULL, 0, 0};
+    Batch *b;
+    int n;
+
+    if (!tasks || !threads)
+        DIE("malloc() failed");
+    pthread_mutex_init(&p.lock, NULL);
+    pthread_cond_init(&p.changed, NULL);
+    p.numSlots = 2 * numThreads + 2; // enough to keep every worker and the writer busy
+    if (!(p.slots = calloc(p.numSlots, sizeof(Batch))))
+        DIE("calloc() failed");
+    p.numRead = p.numTaken = p.numWritten = 0;
+    p.eof = false;
+    p.prog = prog;
+
+    for (int t = 0; t < numThreads; t++) {
+        tasks[t].pipeline = &p;
+        tasks[t].worker = &workers[t];
+        if (pthread_create(&threads[t], NULL, worker, &tasks[t]))
+            DIE("pthread_create() failed");
+    }
+    if (pthread_create(&out, NULL, writer, &p))
+        DIE("pthread_create() failed");
+
+    for (;;) {
+        // wait until the writer has emptied the next slot
+        pthread_mutex_lock(&p.lock);
+        while (p.numRead - p.numWritten == p.numSlots)
+            pthread_cond_wait(&p.changed, &p.lock);
+        b = &p.slots[p.numRead % p.numSlots];
+        pthread_mutex_unlock(&p.lock);
+
+        b->in.len = 0;
+        for (n = 0; n < batchSize && readLine(&line, stdin); n++) {
+            append(&b->in, line.data, line.len);
+            append(&b->in, "\n", 1);
+        }
+
+        pthread_mutex_lock(&p.lock);
+        if (n > 0)
+            p.numRead++;
+        if (n < batchSize)
+            p.eof = true;
+        pthread_cond_broadcast(&p.changed);
+        pthread_mutex_unlock(&p.lock);
+        if (n < batchSize)
+            break;
+    }
+
+    for (int t = 0; t < numThreads; t++)
+        pthread_join(threads[t], NULL);
+    pthread_join(out, NULL);
+
+    for (int s = 0; s < p.numSlots; s++) {
+        free(p.slots[s].in.data);
+        free(p.slots[s].out.data);
+    }
+    free(p.slots);
+    free(line.data);
+    free(tasks);
+    free(threads);
+    pthread_cond_destroy(&p.changed);
+    pthread_mutex_destroy(&p.lock);
+}
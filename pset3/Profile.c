@@ -0,0 +1,113 @@
+/*
+File: Profile.c
+Programmer: Harrison Miller
+Description: per-rule profiling for Subst16 -p.  Each thread counts into its
+own Profile while it filters, so profiling takes no locks; the profiles are
+added together at exit and printed as one table of what each rule cost,
+followed by how many steps (rule applications) the lines needed.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "Subst16.h"
+
+/*
+ * createProfile: return a profile with all counts zero
+ * numRules: number of rules in the program being profiled
+ */
+Profile *createProfile(int numRules)
+{
+    Profile *p = calloc(1, sizeof(Profile));
+
+    if (!p || !(p->rules = calloc(numRules, sizeof(RuleStats))))
+        DIE("calloc() failed");
+    p->numRules = numRules;
+    return p;
+}
+
+/*
+ * countSteps: record that the program took STEPS steps on one line
+ */
+void countSteps(Profile *p, long steps)
+{
+    int k = 0;
+
+    while (k < STEP_BUCKETS - 1 && steps >> (k + 1))
+        k++;
+    p->stepCounts[k]++;
+    p->lines++;
+    p->steps += steps;
+    if (steps > p->maxSteps)
+        p->maxSteps = steps;
+}
+
+/*
+ * mergeProfile: add the counts in src to those in dst
+ */
+void mergeProfile(Profile *dst, const Profile *src)
+{
+    for (int j = 0; j < dst->numRules; j++) {
+        RuleStats *d = &dst->rules[j];
+        const RuleStats *s = &src->rules[j];
+        d->invocations += s->invocations;
+        d->successes += s->successes;
+        d->failures += s->failures;
+        d->scanned += s->scanned;
+        d->replacements += s->replacements;
+        d->nanoseconds += s->nanoseconds;
+    }
+    for (int k = 0; k < STEP_BUCKETS; k++)
+        dst->stepCounts[k] += src->stepCounts[k];
+    dst->lines += src->lines;
+    dst->steps += src->steps;
+    if (src->maxSteps > dst->maxSteps)
+        dst->maxSteps = src->maxSteps;
+}
+
+/*
+ * printProfile: print the table of rule costs and the histogram of steps per line
+ * p: the (merged) profile
+ * prog: the program it was collected on, for the rules' FROMs
+ * fp: where to print it
+ */
+void printProfile(const Profile *p, const Program *prog, FILE *fp)
+{
+    long long total = 0;
+
+    for (int j = 0; j < p->numRules; j++)
+        total += p->rules[j].nanoseconds;
+
+    fprintf(fp, "Subst16: profile of %ld lines, %lld steps (%.2f per line, at most %ld)\n",
+            p->lines, p->steps, p->lines ? (double)p->steps / p->lines : 0.0, p->maxSteps);
+    fprintf(fp, "%6s %12s %12s %12s %14s %12s %10s %6s  %s\n", "rule", "invocations",
+            "successes", "failures", "scanned", "replacements", "ms", "%time", "FROM");
+    for (int j = 0; j < p->numRules; j++) {
+        const RuleStats *r = &p->rules[j];
+        fprintf(fp, "%6d %12ld %12ld %12ld %14lld %12lld %10.3f %6.1f  %.24s\n", j,
+                r->invocations, r->successes, r->failures, r->scanned, r->replacements,
+                r->nanoseconds / 1e6, total ? 100.0 * r->nanoseconds / total : 0.0,
+                prog->code[j].rule.FROM);
+    }
+
+    fprintf(fp, "%14s %12s\n", "steps", "lines");
+    for (int k = 0; k < STEP_BUCKETS; k++) {
+        char range[48];
+        if (!p->stepCounts[k])
+            continue;
+        if (k == 0)
+            snprintf(range, sizeof(range), "1");
+        else
+            snprintf(range, sizeof(range), "%lu-%lu", 1UL << k, (2UL << k) - 1);
+        fprintf(fp, "%14s %12ld\n", range, p->stepCounts[k]);
+    }
+}
+
+/*
+ * destroyProfile: free a profile
+ */
+void destroyProfile(Profile *p)
+{
+    free(p->rules);
+    free(p);
+}
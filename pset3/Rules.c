@@ -0,0 +1,311 @@
+/*
+File: Rules.c
+Programmer: Harrison Miller
+Description: reading Subst16 rules from a file, for rule sets too big for the
+command line.  A rule file is either
+
+  text:      one rule per line, FROM<tab>TO<tab>-FLAGS (blank lines ignored), or
+
+  compiled:  a program written by Subst16 -o, holding the compiled rules
+             (unescaped patterns, wildcard masks, TO templates and jump
+             indices) in the byte order of the machine that wrote it.  It is
+             mmap'd and used in place, so loading it costs one pass to set
+             pointers no matter how many rules it holds.
+*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "Subst16.h"
+
+#define MAGIC "Subst16\n"	/* first bytes of a compiled rule file */
+#define VERSION 1
+
+typedef struct programHeader {
+	char magic[8];		/* MAGIC */
+	uint32_t version;	/* VERSION */
+	uint32_t numRules;
+	uint64_t poolSize;	/* bytes of strings and carets after the records */
+} ProgramHeader;
+
+/* one compiled rule; offsets are into the pool that follows the records */
+typedef struct ruleRecord {
+	uint32_t from, to;		/* FROM and TO as given */
+	uint32_t pattern, wild, text;	/* pattern, wild, and to of the Rule */
+	uint32_t carets;		/* carets of the Rule (4-byte aligned) */
+	int32_t lenFrom, anchor, lenTo, numCarets, lenRep;
+	int32_t onSuccessRuleIndex, onFailureRuleIndex;
+	int32_t filter;
+} RuleRecord;
+
+/*
+ * readFile: read all of a file into a null-terminated string
+ * Returns the string, and sets *len to its length
+ */
+static char *readFile(const char *path, size_t *len)
+{
+    FILE *fp = fopen(path, "rb");
+    Buffer buf = {NULL, 0, 0};
+    size_t n;
+
+    if (!fp) {
+        fprintf(stderr, "Subst16: cannot open %s\n", path);
+        exit(EXIT_FAILURE);
+    }
+    do {
+        reserve(&buf, buf.len + 65536);
+        n = fread(buf.data + buf.len, 1, buf.cap - buf.len - 1, fp);
+        buf.len += n;
+    } while (n > 0);
+    fclose(fp);
+
+    buf.data[buf.len] = '\0';
+    *len = buf.len;
+    return buf.data;
+}
+
+/*
+ * parseRuleFile: compile the rules in a text rule file
+ * path: the file
+ * text: its contents, which the rules' FROMs and TOs will point into
+ * len: length of text
+ * prog: the program to fill in
+ */
+static void parseRuleFile(const char *path, char *text, size_t len, Program *prog)
+{
+    char *s, *end = text + len;
+    char *nl, *tab1, *tab2;
+    int lineNum = 0;
+    int maxRules = 1;
+
+    for (s = text; (s = memchr(s, '\n', end - s)); s++)
+        maxRules++;
+    if (!(prog->code = malloc(maxRules * sizeof(Insn))))
+        DIE("malloc() failed");
+    prog->text = text;
+    prog->numRules = 0;
+
+    for (s = text; s < end; s = nl + 1) {
+        lineNum++;
+        if (!(nl = memchr(s, '\n', end - s)))
+            nl = end;
+        *nl = '\0';
+        if (nl > s && nl[-1] == '\r')
+            nl[-1] = '\0';
+        if (!*s)
+            continue;
+
+        if (!(tab1 = strchr(s, '\t')) || !(tab2 = strchr(tab1 + 1, '\t'))) {
+            fprintf(stderr, "Subst16: %s:%d: expected FROM<tab>TO<tab>-FLAGS\n", path, lineNum);
+            exit(EXIT_FAILURE);
+        }
+        *tab1 = *tab2 = '\0';
+
+        Ruleptr ruleptr = &prog->code[prog->numRules++].rule;
+        ruleptr->FROM = s;
+        ruleptr->TO = tab1 + 1;
+        parseFlags(tab2 + 1, ruleptr);
+        compileRule(ruleptr);
+    }
+}
+
+/*
+ * badFile: report a compiled rule file that is damaged and exit
+ */
+static void badFile(const char *path)
+{
+    fprintf(stderr, "Subst16: %s: not a valid compiled rule file\n", path);
+    exit(EXIT_FAILURE);
+}
+
+/*
+ * mapProgram: map a compiled rule file and point the rules into it
+ * path: the file
+ * prog: the program to fill in
+ */
+static void mapProgram(const char *path, Program *prog)
+{
+    int fd = open(path, O_RDONLY);
+    struct stat st;
+    const ProgramHeader *hdr;
+    const RuleRecord *rec;
+    char *pool;
+    uint64_t n, poolSize;
+
+    if (fd < 0 || fstat(fd, &st) < 0)
+        badFile(path);
+    if ((size_t)st.st_size < sizeof(ProgramHeader))
+        badFile(path);
+    prog->mapSize = st.st_size;
+    if ((prog->map = mmap(NULL, prog->mapSize, PROT_READ, MAP_PRIVATE, fd, 0)) == MAP_FAILED)
+        badFile(path);
+    close(fd);
+
+    hdr = prog->map;
+    n = hdr->numRules;
+    poolSize = hdr->poolSize;
+    if (memcmp(hdr->magic, MAGIC, 8) != 0 || hdr->version != VERSION || n == 0
+        || prog->mapSize != sizeof(ProgramHeader) + n * sizeof(RuleRecord) + poolSize
+        || poolSize == 0)
+        badFile(path);
+    rec = (const RuleRecord*)(hdr + 1);
+    pool = (char*)(rec + n);
+    if (pool[poolSize - 1] != '\0') // so every string in the pool is terminated
+        badFile(path);
+
+    prog->numRules = n;
+    if (!(prog->code = malloc(n * sizeof(Insn))))
+        DIE("malloc() failed");
+
+    for (uint64_t j = 0; j < n; j++, rec++) {
+        Rule *rule = &prog->code[j].rule;
+
+        // every offset and length must stay inside the pool
+        if (rec->from >= poolSize || rec->to >= poolSize
+            || rec->lenFrom < 0 || rec->lenTo < 0 || rec->numCarets < 0
+            || rec->pattern + (uint64_t)rec->lenFrom >= poolSize
+            || rec->wild + (uint64_t)rec->lenFrom >= poolSize
+            || rec->text + (uint64_t)rec->lenTo >= poolSize
+            || rec->carets % sizeof(int) != 0
+            || rec->carets + (uint64_t)rec->numCarets * sizeof(int) > poolSize
+            || rec->anchor < -1 || rec->anchor >= rec->lenFrom
+            || rec->lenRep != rec->lenTo + rec->numCarets * rec->lenFrom
+            || rec->onSuccessRuleIndex < -1 || rec->onFailureRuleIndex < -1
+            || (rec->filter != 'g' && rec->filter != 'q' && rec->filter != 'r'))
+            badFile(path);
+
+        rule->FROM = pool + rec->from;
+        rule->TO = pool + rec->to;
+        rule->pattern = pool + rec->pattern;
+        rule->wild = pool + rec->wild;
+        rule->to = pool + rec->text;
+        rule->carets = (int*)(pool + rec->carets);
+        rule->lenFrom = rec->lenFrom;
+        rule->anchor = rec->anchor;
+        rule->lenTo = rec->lenTo;
+        rule->numCarets = rec->numCarets;
+        rule->lenRep = rec->lenRep;
+        rule->onSuccessRuleIndex = rec->onSuccessRuleIndex;
+        rule->onFailureRuleIndex = rec->onFailureRuleIndex;
+        rule->filter = rec->filter;
+
+        for (int k = 0; k < rule->numCarets; k++)
+            if (rule->carets[k] < (k ? rule->carets[k-1] : 0) || rule->carets[k] > rule->lenTo)
+                badFile(path);
+    }
+}
+
+/*
+ * loadRules: read the rules in a text or compiled rule file
+ * path: the file
+ * prog: the program to fill in (not yet linked)
+ */
+void loadRules(const char *path, Program *prog)
+{
+    char magic[8];
+    FILE *fp = fopen(path, "rb");
+    bool compiled;
+
+    if (!fp) {
+        fprintf(stderr, "Subst16: cannot open %s\n", path);
+        exit(EXIT_FAILURE);
+    }
+    compiled = fread(magic, 1, 8, fp) == 8 && memcmp(magic, MAGIC, 8) == 0;
+    fclose(fp);
+
+    if (compiled) {
+        mapProgram(path, prog);
+    } else {
+        size_t len;
+        char *text = readFile(path, &len);
+        parseRuleFile(path, text, len, prog);
+    }
+    if (prog->numRules == 0) {
+        fprintf(stderr, "Subst16: %s: no rules\n", path);
+        exit(EXIT_FAILURE);
+    }
+}
+
+/*
+ * addToPool: append N bytes to the pool, first padding it to a multiple of ALIGN
+ * Returns the offset at which they were put
+ */
+static uint32_t addToPool(Buffer *pool, const void *src, size_t n, size_t align)
+{
+    while (pool->len % align)
+        append(pool, "", 1);
+    if (pool->len + n > UINT32_MAX)
+        DIE("Subst16: rule set too large to compile");
+    append(pool, src, n);
+    return pool->len - n;
+}
+
+/*
+ * saveProgram: write a program as a compiled rule file
+ * prog: the program
+ * path: the file to write
+ */
+void saveProgram(const Program *prog, const char *path)
+{
+    int n = prog->numRules;
+    RuleRecord *recs = calloc(n, sizeof(RuleRecord));
+    Buffer pool = {NULL, 0, 0};
+    ProgramHeader hdr;
+    FILE *fp;
+
+    if (!recs)
+        DIE("calloc() failed");
+    for (int j = 0; j < n; j++) {
+        const Rule *rule = &prog->code[j].rule;
+        RuleRecord *rec = &recs[j];
+
+        rec->from = addToPool(&pool, rule->FROM, strlen(rule->FROM) + 1, 1);
+        rec->to = addToPool(&pool, rule->TO, strlen(rule->TO) + 1, 1);
+        rec->pattern = addToPool(&pool, rule->pattern, rule->lenFrom + 1, 1);
+        rec->wild = addToPool(&pool, rule->wild, rule->lenFrom + 1, 1);
+        rec->text = addToPool(&pool, rule->to, rule->lenTo + 1, 1);
+        rec->carets = addToPool(&pool, rule->carets, rule->numCarets * sizeof(int), sizeof(int));
+        rec->lenFrom = rule->lenFrom;
+        rec->anchor = rule->anchor;
+        rec->lenTo = rule->lenTo;
+        rec->numCarets = rule->numCarets;
+        rec->lenRep = rule->lenRep;
+        rec->onSuccessRuleIndex = rule->onSuccessRuleIndex;
+        rec->onFailureRuleIndex = rule->onFailureRuleIndex;
+        rec->filter = rule->filter;
+    }
+    append(&pool, "", 1); // the pool always ends with a null
+
+    memset(&hdr, 0, sizeof(hdr));
+    memcpy(hdr.magic, MAGIC, 8);
+    hdr.version = VERSION;
+    hdr.numRules = n;
+    hdr.poolSize = pool.len;
+
+    if (!(fp = fopen(path, "wb"))
+        || fwrite(&hdr, sizeof(hdr), 1, fp) != 1
+        || fwrite(recs, sizeof(RuleRecord), n, fp) != (size_t)n
+        || fwrite(pool.data, 1, pool.len, fp) != pool.len
+        || fclose(fp) != 0) {
+        fprintf(stderr, "Subst16: cannot write %s\n", path);
+        exit(EXIT_FAILURE);
+    }
+    free(recs);
+    free(pool.data);
+}
+
+/*
+ * unmapProgram: release the mapping of a compiled rule file
+ */
+void unmapProgram(Program *prog)
+{
+    munmap(prog->map, prog->mapSize);
+    prog->map = NULL;
+}
@@ -0,0 +1,186 @@
+/*
+File: Stream.c
+Programmer: Harrison Miller
+Description: streaming mode for Subst16 -s, which filters lines of any length
+(a multi-gigabyte line of JSON, say) in constant memory.
+
+A line is read in chunks and passed through a chain of stages, one per rule.
+Each stage scans what it is given for its rule's FROM, sends the text before a
+match and then the replacement on to the next stage, and holds back only the
+last lenFrom-1 characters, in case a match starts there and finishes in the
+next piece.  The last stage writes to stdout, so output appears as the input
+is read.
+
+That only works if the rules can be applied before the line has been seen to
+its end, so the program must consist of 'g' and 'q' rules whose next rule does
+not depend on whether they succeeded; canStream() checks this.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "Subst16.h"
+
+#define CHUNK 65536	/* bytes of input read at a time */
+#define WINDOW 4096	/* bytes a stage scans at a time, besides what it holds back */
+
+typedef struct stage {
+	const Rule *rule;
+	struct stage *next;	/* the stage that gets this one's output, NULL for stdout */
+	char *buf;		/* held-back characters followed by new input */
+	size_t len;		/* characters in buf */
+	size_t cap;		/* WINDOW + lenFrom */
+	char *rep;		/* where each replacement is built */
+	bool done;		/* a 'q' rule that has replaced its match in this line */
+} Stage;
+
+static void feed(Stage *st, const char *s, size_t n, FILE *out);
+
+/*
+ * canStream: whether a program can be run a piece of a line at a time
+ * prog: a linked program
+ *
+ * Returns true if every rule the program runs is 'g' or 'q' and goes to the
+ * same next rule whether it succeeds or fails, without coming back to a rule
+ */
+bool canStream(const Program *prog)
+{
+    int steps = 0;
+
+    for (const Insn *ip = prog->code; ip; ip = ip->next[false]) {
+        if (ip->rule.filter == 'r' || ip->next[false] != ip->next[true])
+            return false;
+        if (++steps > prog->numRules)
+            return false; // a loop, which would never finish any line
+    }
+    return true;
+}
+
+/*
+ * emit: send N characters of output from a stage to the next one
+ */
+static void emit(Stage *next, const char *s, size_t n, FILE *out)
+{
+    if (next)
+        feed(next, s, n, out);
+    else
+        fwrite(s, 1, n, out);
+}
+
+/*
+ * scan: replace the matches in a stage's buffer and pass its contents on
+ * st: the stage
+ * last: true at the end of the line, when nothing need be held back
+ * out: where the last stage writes
+ */
+static void scan(Stage *st, bool last, FILE *out)
+{
+    const Rule *rule = st->rule;
+    const char *p = st->buf;
+    const char *end = st->buf + st->len;
+    const char *m;
+    size_t keep;
+
+    while (!st->done && (m = StrStr(p, end, rule))) {
+        emit(st->next, p, m - p, out);
+        putReplacement(st->rep, rule, m);
+        emit(st->next, st->rep, rule->lenRep, out);
+        p = m + rule->lenFrom;
+        if (rule->filter == 'q')
+            st->done = true;
+    }
+
+    // no match starts before end-(lenFrom-1), so only that much is held back
+    keep = (st->done || last) ? 0 : end - p;
+    if (keep > (size_t)rule->lenFrom - 1)
+        keep = rule->lenFrom - 1;
+    emit(st->next, p, end - p - keep, out);
+    memmove(st->buf, end - keep, keep);
+    st->len = keep;
+}
+
+/*
+ * feed: give a stage N more characters of the line
+ */
+static void feed(Stage *st, const char *s, size_t n, FILE *out)
+{
+    while (n > 0) {
+        if (st->done) {
+            emit(st->next, s, n, out);
+            return;
+        }
+        size_t k = st->cap - st->len;
+        if (k > n)
+            k = n;
+        memcpy(st->buf + st->len, s, k);
+        st->len += k;
+        s += k;
+        n -= k;
+        if (st->len == st->cap)
+            scan(st, false, out);
+    }
+}
+
+/*
+ * endLine: flush every stage at the end of a line and ready them for the next
+ */
+static void endLine(Stage *first, FILE *out)
+{
+    for (Stage *st = first; st; st = st->next) {
+        if (!st->done)
+            scan(st, true, out); // its output goes to stages not yet flushed
+        st->len = 0;
+        st->done = false;
+    }
+    putc('\n', out);
+}
+
+/*
+ * runStream: filter in to out one chunk at a time
+ * prog: a linked program for which canStream() is true
+ */
+void runStream(const Program *prog, FILE *in, FILE *out)
+{
+    Stage *stages = calloc(prog->numRules, sizeof(Stage));
+    Stage *first = NULL, **link = &first;
+    char *chunk = malloc(CHUNK);
+    size_t n;
+    bool partial = false; // part of a line has been read
+
+    if (!stages || !chunk)
+        DIE("malloc() failed");
+
+    // a stage for each rule the program runs, in order; rules that never
+    // match anything (an empty FROM) are left out
+    for (const Insn *ip = prog->code; ip; ip = ip->next[false]) {
+        Stage *st = &stages[ip - prog->code];
+        if (ip->rule.lenFrom == 0)
+            continue;
+        st->rule = &ip->rule;
+        st->cap = WINDOW + ip->rule.lenFrom;
+        if (!(st->buf = malloc(st->cap)) || !(st->rep = malloc(ip->rule.lenRep + 1)))
+            DIE("malloc() failed");
+        *link = st;
+        link = &st->next;
+    }
+
+    while ((n = fread(chunk, 1, CHUNK, in)) > 0) {
+        const char *s = chunk, *end = chunk + n, *nl;
+        while ((nl = memchr(s, '\n', end - s))) {
+            emit(first, s, nl - s, out);
+            endLine(first, out);
+            s = nl + 1;
+        }
+        emit(first, s, end - s, out);
+        partial = s < end;
+    }
+    if (partial)
+        endLine(first, out); // the last line had no newline
+
+    for (int j = 0; j < prog->numRules; j++) {
+        free(stages[j].buf);
+        free(stages[j].rep);
+    }
+    free(stages);
+    free(chunk);
+}
@@ -2,61 +2,95 @@
 File: Subst16.c
 Programmer: Harrison Miller
 Description: 
+
+    Subst16 [-jN] [-bN] [-cN[K|M|G]] [-s] [-p | -P FILE] [-o FILE] [--] (FROM TO -FLAGS)*
+    Subst16 [options] -f FILE
+
+Options are recognized only before the first rule, and parsing stops at the
+first argument that is not one.  A FROM that starts with '-' and could be
+read as an option ("-p", "-s", "-j4", ...) must come after "--".  When an
+argument taken as an option could instead have begun the rules, Subst16 says
+so on stderr.
 */
 
+#define _POSIX_C_SOURCE 200809L
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <stdbool.h>
 #include <ctype.h>
+#include <time.h>
+#include <unistd.h>
 #include "Subst16.h"
-#include "/c/cs223/Hwk3/getLine.h"
+
+#define THREADS_PER_CPU 4 // most worker threads (-jN) per online processor
 
 /* 
  * StrStr: custom strstr to handle wildcard searches
  * str: string to be searched
- * target: target substring
+ * end: end of the string to be searched
+ * rule: rule whose compiled FROM pattern is the target substring
  *
- * Returns a char array with pointer at index of first of occurrence of target in str
+ * Returns a pointer to the first occurrence of the pattern that lies entirely in [str, end), or NULL
  */
-char* StrStr(const char *str, const char *target) 
+char* StrStr(const char *str, const char *end, const Rule *rule)
 {
-  if (!*target) return NULL;
-  char *p1 = (char*)str;
-  while (*p1) {
-    char *p1_begin = p1, 
-    *p2 = (char*)target;
-    while (*p1 && *p2 && (*p1 == *p2 || *p2 == '.')) {
-      if(*p1 == '@' && *(p1+1) == '.') {
-        p1+=2;
-      }  
-      p1++;
-      p2++;
+    int n = rule->lenFrom;
+    int a = rule->anchor;
+    const char *last; /* last position at which a match can start */
+
+    if (n == 0 || end - str < n) return NULL;
+    last = end - n;
+    if (a < 0) return (char*)str; // all wildcards matches anywhere
+
+    // find each occurrence of the first literal character, then check the rest
+    for (const char *p = str + a; (p = memchr(p, rule->pattern[a], last + a + 1 - p)); p++) {
+        const char *begin = p - a;
+        int i;
+        for (i = 0; i < n && (rule->wild[i] || begin[i] == rule->pattern[i]); i++)
+            ;
+        if (i == n)
+            return (char*)begin;
     }
-    if (!*p2)
-      return p1_begin;
-    p1 = p1_begin + 1;
-  }
-  return NULL;
+    return NULL;
 }
 
 /* 
- * copylastn: copy n characters of src into the end of dest
- * dest: string that will be copied into
- * source: string to be copied
- * n: number of characters to copy
- *
- * Returns a char array of the dest string with n chars of src copied into the end of it
+ * reserve: make sure a buffer can hold a string of length n
+ * buf: the buffer
+ * n: length of string (not counting the null terminator)
+ */
+void reserve(Buffer *buf, size_t n)
+{
+    if (n < buf->cap)
+        return;
+    size_t cap = buf->cap ? 2 * buf->cap : 128;
+    while (cap <= n)
+        cap *= 2;
+    if (!(buf->data = realloc(buf->data, cap)))
+        DIE("realloc() failed");
+    buf->cap = cap;
+}
+
+/* 
+ * append: copy n characters to the end of a buffer (does not null terminate)
  */
-char *copylastn(char *dest, char *src,int n)
+void append(Buffer *buf, const char *src, size_t n)
 {
-    if (!src)
-        src = "";
-    if (!dest)
-        dest = "";
+    reserve(buf, buf->len + n);
+    memcpy(buf->data + buf->len, src, n);
+    buf->len += n;
+}
 
-        strncpy(dest+(strlen(dest)-strlen(src)), src, strlen(src));
-        return dest;
+/* 
+ * swapBuffers: exchange the contents of two buffers
+ */
+static void swapBuffers(Buffer *a, Buffer *b)
+{
+    Buffer t = *a;
+    *a = *b;
+    *b = t;
 }
 
 /* 
@@ -120,121 +154,490 @@ void parseFlags(char* flags, Ruleptr ruleptr)
 }
 
 /* 
- * str_replace: finds a substring and replaces all `from` occurrences with `to` according to flag specifier
- * orig: the string to filter
- * from: the substring to be replaced
- * to: the replacement string
- * flag: specifies the filter to apply
- * 
- * Returns the filtered orig string
+ * compileRule: unescape FROM and TO once so that matching and replacing need no parsing
+ * ruleptr: a pointer to the current rule
+ *
+ * In FROM an unescaped '.' matches any character; in TO an unescaped '^' stands for
+ * the matched text. '@' escapes the character that follows it in either string.
  */
-char *str_replace(char *orig, char *from, char *to, char flag) {
-    char *result = NULL; /* the return string */
-    char *ins = NULL;    /* the next insert point */
-    char *tmp = NULL;    /* temporary */
-    char *matched = NULL; /* matched string */
-    char *to_cpy = NULL; /* copy of to argument */
-    int len_from;  /* length of from */
-    int len_to; /* length of to */
-    int len_front; /* distance between from and end of last from */
-    int count;    /* number of replacements */
-
-    if (!orig)
-        return NULL;
-    if (!from)
-        from = "";
-    len_from = strlen(from);
-    if (!to)
-        to = "";
-    len_to = strlen(to);
-
-    // copy to to_cpy
-    to_cpy = malloc(strlen(to) + 1);
-    strcpy(to_cpy, to);
-    to_cpy[strlen(to)] = '\0';
-
-    int max_num_matches = strlen(orig)/strlen(from);
-    char *matches[max_num_matches];
-    memset(matches, 0, max_num_matches * sizeof(char*));
-
-    if(flag == 'g' || flag == 'q') {
-        ins = orig;
-        for (count = 0; (tmp = StrStr(ins, from)); ++count) {
-            if(flag == 'q' && count == 1) {
-               break;
-            }
-            ins = tmp + len_from;
+void compileRule(Ruleptr ruleptr)
+{
+    int n = strlen(ruleptr->FROM);
+    int m = strlen(ruleptr->TO);
+    char *s;
+
+    // one block per rule: carets (first, for alignment), then pattern, wild, and to
+    if (!(ruleptr->carets = malloc((m + 1) * sizeof(int) + 2 * (n + 1) + m + 1)))
+        DIE("malloc() failed");
+    ruleptr->pattern = (char*)(ruleptr->carets + m + 1);
+    ruleptr->wild = ruleptr->pattern + n + 1;
+    ruleptr->to = ruleptr->wild + n + 1;
+
+    ruleptr->lenFrom = 0;
+    ruleptr->anchor = -1;
+    for (s = ruleptr->FROM; *s; s++) {
+        bool escaped = (*s == '@' && s[1]);
+        if (escaped) s++;
+        ruleptr->wild[ruleptr->lenFrom] = (!escaped && *s == '.');
+        if (ruleptr->anchor < 0 && !ruleptr->wild[ruleptr->lenFrom])
+            ruleptr->anchor = ruleptr->lenFrom;
+        ruleptr->pattern[ruleptr->lenFrom++] = *s;
+    }
+    ruleptr->pattern[ruleptr->lenFrom] = '\0';
+
+    ruleptr->lenTo = ruleptr->numCarets = 0;
+    for (s = ruleptr->TO; *s; s++) {
+        bool escaped = (*s == '@' && s[1]);
+        if (escaped) s++;
+        if (!escaped && *s == '^')
+            ruleptr->carets[ruleptr->numCarets++] = ruleptr->lenTo;
+        else
+            ruleptr->to[ruleptr->lenTo++] = *s;
+    }
+    ruleptr->to[ruleptr->lenTo] = '\0';
+    ruleptr->lenRep = ruleptr->lenTo + ruleptr->numCarets * ruleptr->lenFrom;
+}
 
-            matched = malloc(3 * sizeof(*matched));
-            matched = strncpy(matched, tmp, 2);
-            matched[2] = '\0';
+/* 
+ * putReplacement: write the replacement for one match
+ * dest: where to write the replacement (room for rule->lenRep characters)
+ * rule: the rule being applied
+ * match: the matched text (rule->lenFrom characters)
+ *
+ * Returns true if the replacement differs from the matched text
+ */
+bool putReplacement(char *dest, const Rule *rule, const char *match)
+{
+    char *d = dest;
+    int prev = 0;
+
+    for (int k = 0; k < rule->numCarets; k++) {
+        memcpy(d, rule->to + prev, rule->carets[k] - prev);
+        d += rule->carets[k] - prev;
+        memcpy(d, match, rule->lenFrom);
+        d += rule->lenFrom;
+        prev = rule->carets[k];
+    }
+    memcpy(d, rule->to + prev, rule->lenTo - prev);
 
-            if(strchr(to, '^')) {
-                to_cpy = to; // reset to_cpy
-                to_cpy = str_replace(to_cpy, "^", matched, 'q');
-                len_to = strlen(to_cpy);
-                matches[count] = to_cpy;
-            }
+    return rule->lenRep != rule->lenFrom || memcmp(dest, match, rule->lenFrom) != 0;
+}
 
-            free(matched);
-        }
+/* 
+ * find: StrStr, charging the bytes it looks at to stats when profiling
+ * stats: the rule's profile counters, or NULL
+ */
+static inline const char *find(const char *s, const char *end, const Rule *rule, RuleStats *stats)
+{
+    const char *m = StrStr(s, end, rule);
+
+    if (stats)
+        stats->scanned += (m ? m + rule->lenFrom : end) - s;
+    return m;
+}
+
+/* 
+ * rewrite: copy cur into tmp, replacing the match at m and (for 'g') every later one
+ * Returns true if the result differs from cur
+ */
+static bool rewrite(const Rule *rule, const Buffer *cur, Buffer *tmp, const char *m,
+                    RuleStats *stats)
+{
+    const char *s = cur->data;
+    const char *end = cur->data + cur->len;
+    bool changed = false;
+
+    tmp->len = 0;
+    do {
+        append(tmp, s, m - s);
+        reserve(tmp, tmp->len + rule->lenRep);
+        changed |= putReplacement(tmp->data + tmp->len, rule, m);
+        tmp->len += rule->lenRep;
+        s = m + rule->lenFrom;
+        if (stats)
+            stats->replacements++;
+    } while (rule->filter == 'g' && (m = find(s, end, rule, stats)));
+    append(tmp, s, end - s);
+    tmp->data[tmp->len] = '\0';
+
+    return changed;
+}
 
-        if(result && tmp) {
-           result = tmp = realloc(result, strlen(orig) + (len_to - len_from) * count + 1);
-        } else {
-            result = tmp = malloc(strlen(orig) + (len_to - len_from) * count + 1);
+/* 
+ * repeat: apply an 'r' rule, replacing the leftmost match until there is none
+ * rule: the rule being applied
+ * cur: holds the string to filter; its storage is reused for the unscanned text
+ * tmp: receives the filtered string
+ * m: the leftmost match in cur
+ *
+ * Text before a replacement has already been scanned, so a new match can start
+ * at most lenFrom-1 characters before it.  Instead of rescanning from the start
+ * of the string, those characters and the replacement are pushed back in front
+ * of the unscanned text in cur and scanning resumes there.  The result is the
+ * same as rescanning from the start, but each replacement costs only
+ * O(lenFrom + lenRep) to redo.
+ *
+ * Returns true if the result differs from cur
+ */
+static bool repeat(const Rule *rule, Buffer *cur, Buffer *tmp, const char *m,
+                   RuleStats *stats)
+{
+    char *p = cur->data;		/* start of the unscanned text */
+    char *end = cur->data + cur->len;	/* end of the unscanned text */
+    size_t back;			/* characters to push back in front of p */
+    bool changed = false;
+
+    tmp->len = 0;
+    while (m) {
+        append(tmp, p, m - p);
+        reserve(tmp, tmp->len + rule->lenRep);
+        p = (char*)m + rule->lenFrom;
+        if (!putReplacement(tmp->data + tmp->len, rule, m)) {
+            // replacing it again would not change anything, so we are done
+            tmp->len += rule->lenRep;
+            break;
+        }
+        tmp->len += rule->lenRep;
+        changed = true;
+        if (stats)
+            stats->replacements++;
+
+        back = rule->lenRep + rule->lenFrom - 1;
+        if (back > tmp->len)
+            back = tmp->len;
+        if ((size_t)(p - cur->data) < back) {
+            // make room in front of the unscanned text, as much again as its length
+            size_t n = end - p;
+            size_t off = p - cur->data;
+            size_t room = back + n;
+            reserve(cur, room + n);
+            memmove(cur->data + room, cur->data + off, n);
+            p = cur->data + room;
+            end = p + n;
         }
+        p -= back;
+        tmp->len -= back;
+        memcpy(p, tmp->data + tmp->len, back);
+
+        m = find(p, end, rule, stats);
+    }
+    append(tmp, p, end - p);
+    tmp->data[tmp->len] = '\0';
+
+    return changed;
+}
+
+/* 
+ * apply: applyRule, counting what it does in stats unless that is NULL
+ */
+static inline bool apply(const Rule *rule, Buffer *cur, Buffer *tmp, RuleStats *stats)
+{
+    const char *m = find(cur->data, cur->data + cur->len, rule, stats);
+    bool changed;
+
+    if (!m)
+        return false;
+    if (rule->filter == 'r')
+        changed = repeat(rule, cur, tmp, m, stats);
+    else
+        changed = rewrite(rule, cur, tmp, m, stats);
+    if (changed)
+        swapBuffers(cur, tmp);
+    return changed;
+}
+
+/* 
+ * applyRule: applies a rule to the string in cur according to its filter
+ * rule: the rule to apply
+ * cur: holds the string to filter, and the filtered string on return
+ * tmp: scratch buffer; its contents are exchanged with cur's when the string changes
+ *
+ * Returns true if the string changed, so the caller never has to compare strings
+ */
+bool applyRule(const Rule *rule, Buffer *cur, Buffer *tmp)
+{
+    return apply(rule, cur, tmp, NULL);
+}
 
-        for(int i = 0; i < strlen(orig) + (len_to - len_from) * count + 1; i++) {
-            tmp[i] = '\0';
+/* 
+ * readLine: read the next line of fp into buf, without its newline
+ * Returns false at end of file
+ */
+bool readLine(Buffer *buf, FILE *fp)
+{
+    buf->len = 0;
+    for (;;) {
+        reserve(buf, buf->len + 128);
+        if (!fgets(buf->data + buf->len, buf->cap - buf->len, fp))
+            return buf->len > 0;
+        buf->len += strlen(buf->data + buf->len);
+        if (buf->len && buf->data[buf->len-1] == '\n') {
+            buf->data[--buf->len] = '\0';
+            return true;
         }
+    }
+}
+
+/* 
+ * canChange: whether applying a rule can ever change a line
+ * The replacement is the same as the match only if it is a lone '^', or a
+ * literal TO equal to a FROM with no wildcards; an empty FROM never matches.
+ */
+static bool canChange(const Rule *rule)
+{
+    if (rule->lenFrom == 0)
+        return false;
+    if (rule->numCarets == 1 && rule->lenTo == 0)
+        return false;
+    if (rule->numCarets == 0 && rule->lenTo == rule->lenFrom
+        && !memchr(rule->wild, true, rule->lenFrom)
+        && memcmp(rule->to, rule->pattern, rule->lenFrom) == 0)
+        return false;
+    return true;
+}
 
-        if (!result) return NULL;
-
-        int i = 0;
-        while (i < count) {
-            if(matches[i]) to_cpy = matches[i];
-            ins = StrStr(orig, from);
-            len_front = ins - orig;
-            tmp = strncpy(tmp, orig, len_front) + len_front;
-            tmp = strcpy(tmp, to_cpy) + len_to;
-            orig += len_front + len_from;
-            i++;
+/* 
+ * checkProgram: warn about rules that can never run and about cycles of
+ * failure jumps, which loop forever on any line none of their rules change
+ * prog: a linked program
+ */
+void checkProgram(const Program *prog)
+{
+    int n = prog->numRules;
+    const Insn *code = prog->code;
+    char *color = calloc(n, 1); // 0 = unreached, 1 = reached, 2 = on current path, 3 = done
+    int *stack = malloc(n * sizeof(int));
+    int sp = 0;
+
+    if (!color || !stack)
+        DIE("malloc() failed");
+
+    // find the rules reachable from rule 0; success jumps of rules that cannot
+    // change a line are never taken
+    color[0] = 1;
+    stack[sp++] = 0;
+    while (sp > 0) {
+        int j = stack[--sp];
+        for (int k = canChange(&code[j].rule); k >= 0; k--) {
+            const Insn *t = code[j].next[k];
+            if (t && !color[t - code]) {
+                color[t - code] = 1;
+                stack[sp++] = t - code;
+            }
         }
-        strcpy(tmp, orig);
     }
-    else if(flag == 'r') {
-        int len_tmp;
 
-        len_tmp = strlen(orig) + (len_to - len_from);
-        tmp = result = malloc(len_tmp+2);
-        if (!result) return NULL;
+    for (int j = 0; j < n; j++) {
+        if (!color[j])
+            fprintf(stderr, "Subst16: warning: rule %d can never be reached\n", j);
+        else if (!canChange(&code[j].rule))
+            fprintf(stderr, "Subst16: warning: rule %d can never change a line\n", j);
+    }
 
-        for(int i = 0; i < len_tmp; i++) {
-            tmp[i] = '\0';
+    // failure jumps form a graph in which each rule has at most one successor,
+    // so each cycle is found by walking forward until a rule repeats
+    for (int j = 0; j < n; j++) {
+        const Insn *ip;
+        if (color[j] != 1)
+            continue;
+        for (ip = &code[j]; ip && color[ip - code] == 1; ip = ip->next[false])
+            color[ip - code] = 2;
+        if (ip && color[ip - code] == 2) {
+            const Insn *start = ip;
+            fprintf(stderr, "Subst16: warning: rules %d", (int)(start - code));
+            for (ip = start->next[false]; ip != start; ip = ip->next[false])
+                fprintf(stderr, " -> %d", (int)(ip - code));
+            fprintf(stderr, " -> %d loop forever on a line none of them change\n", (int)(start - code));
         }
+        for (ip = &code[j]; ip && color[ip - code] == 2; ip = ip->next[false])
+            color[ip - code] = 3;
+    }
+
+    free(color);
+    free(stack);
+}
+
+/* 
+ * linkProgram: resolve each rule's Sn/Fm indices to pointers to the next rule,
+ * NULL meaning stop
+ * prog: program whose rules have been parsed and compiled
+ */
+void linkProgram(Program *prog)
+{
+    int n = prog->numRules;
 
-        tmp = strcpy(tmp, orig);
+    for (int j = 0; j < n; j++) {
+        Insn *ip = &prog->code[j];
+        int target[2] = { ip->rule.onFailureRuleIndex, ip->rule.onSuccessRuleIndex };
 
-        while(StrStr(tmp, from)) { // while there is a leftmost occurrence of from
-            ins = StrStr(tmp, from);
-            tmp = str_replace(tmp + (ins-tmp), from, to, 'q');
-            result = copylastn(result, tmp, strlen(tmp));
-            tmp = realloc(tmp, strlen(orig)+1);
+        for (int k = 0; k < 2; k++) {
+            // if no Sn or Fm rule specified, go to next rule if it exists
+            if (target[k] == -1)
+                target[k] = j + 1;
+            ip->next[k] = (target[k] < n) ? &prog->code[target[k]] : NULL;
         }
     }
+}
+
+/* 
+ * runProgram: run the rule program on one line, starting with rule 0
+ * prog: the linked program
+ * cur: holds the line, and the filtered line on return
+ * tmp: scratch buffer for applyRule
+ */
+void runProgram(const Program *prog, Buffer *cur, Buffer *tmp)
+{
+    for (const Insn *ip = prog->code; ip; ip = ip->next[applyRule(&ip->rule, cur, tmp)])
+        ;
+}
+
+/* 
+ * profileProgram: runProgram, timing each step and counting it in w->profile
+ * prog: the linked program
+ * w: the calling thread's state; the line is in w->cur
+ */
+void profileProgram(const Program *prog, Worker *w)
+{
+    Profile *p = w->profile;
+    struct timespec t0, t1;
+    long steps = 0;
+    bool changed;
+
+    for (const Insn *ip = prog->code; ip; ip = ip->next[changed], steps++) {
+        RuleStats *stats = &p->rules[ip - prog->code];
+
+        clock_gettime(CLOCK_MONOTONIC, &t0);
+        changed = apply(&ip->rule, &w->cur, &w->tmp, stats);
+        clock_gettime(CLOCK_MONOTONIC, &t1);
+
+        stats->nanoseconds += (t1.tv_sec - t0.tv_sec) * 1000000000LL + (t1.tv_nsec - t0.tv_nsec);
+        stats->invocations++;
+        if (changed)
+            stats->successes++;
+        else
+            stats->failures++;
+    }
+    countSteps(p, steps);
+}
+
+/* 
+ * run: run the program on w->cur, profiling it if w has a profile
+ */
+static void run(const Program *prog, Worker *w)
+{
+    if (w->profile)
+        profileProgram(prog, w);
+    else
+        runProgram(prog, &w->cur, &w->tmp);
+}
+
+/* 
+ * filterLine: run the rule program on the line in w->cur, consulting and
+ * filling w's cache if it has one
+ * prog: the linked program
+ * w: the calling thread's state
+ */
+void filterLine(const Program *prog, Worker *w)
+{
+    const char *val;
+    size_t valLen;
+
+    if (!w->cache) {
+        run(prog, w);
+        return;
+    }
+
+    if (lookupCache(w->cache, w->cur.data, w->cur.len, &val, &valLen)) {
+        w->cur.len = 0;
+        append(&w->cur, val, valLen);
+        w->cur.data[w->cur.len] = '\0';
+        return;
+    }
+
+    w->key.len = 0;
+    append(&w->key, w->cur.data, w->cur.len);
+    run(prog, w);
+    insertCache(w->cache, w->key.data, w->key.len, w->cur.data, w->cur.len);
+}
 
-    free(to_cpy);
-    return result;
+/* 
+ * freeProgram: free the storage used by a program's rules
+ */
+void freeProgram(Program *prog)
+{
+    if (prog->map) {
+        unmapProgram(prog);
+    } else {
+        for (int j = 0; j < prog->numRules; j++)
+            free(prog->code[j].rule.carets); // the block compileRule() allocated
+    }
+    free(prog->code);
+    free(prog->text);
+}
+
+/* 
+ * parseSize: parses an option of the form -<opt><number>[K|M|G]
+ * arg: the argument
+ * opt: the option letter
+ * n: where to store the number of bytes
+ *
+ * Returns true if arg is such an option
+ */
+static bool parseSize(const char *arg, char opt, size_t *n)
+{
+    char *ptr;
+    unsigned long long val;
+
+    if(arg[0] != '-' || arg[1] != opt || !isdigit(arg[2]))
+        return false;
+    val = strtoull(arg+2, &ptr, 10);
+    if(*ptr == 'K' || *ptr == 'k')
+        val <<= 10, ptr++;
+    else if(*ptr == 'M' || *ptr == 'm')
+        val <<= 20, ptr++;
+    else if(*ptr == 'G' || *ptr == 'g')
+        val <<= 30, ptr++;
+    if(*ptr)
+        exit(EXIT_FAILURE);
+    *n = val;
+    return true;
+}
+
+/* 
+ * parseCount: parses an option of the form -<opt><positive number>
+ * arg: the argument
+ * opt: the option letter
+ * n: where to store the number
+ *
+ * Returns true if arg is such an option
+ */
+static bool parseCount(const char *arg, char opt, int *n)
+{
+    char *ptr;
+    long val;
+
+    if(arg[0] != '-' || arg[1] != opt || !isdigit(arg[2]))
+        return false;
+    val = strtol(arg+2, &ptr, 10);
+    if(*ptr || val < 1 || val > 1<<20)
+        exit(EXIT_FAILURE);
+    *n = val;
+    return true;
 }
 
 int main(int argc, char *argv[])
 {
     int i;
-    int numRules = (argc-1)/3; // number of rules 
-    int ruleIdx = 0; // index of rule (ptr) in array of rule pointers 
-    Ruleptr rules[numRules]; // create an array of rule pointers
-    Ruleptr currentRulePtr; // pointer to current rule
+    int first; // index of first rule argument
+    int numThreads = 1; // number of worker threads (-jN)
+    int batchSize = 1024; // lines per batch when threaded (-bN)
+    size_t cacheSize = 0; // bytes of cache for repeated lines, 0 for none (-cN[K|M|G])
+    char *ruleFile = NULL; // file to read the rules from (-f FILE)
+    char *outFile = NULL; // file to write the compiled rules to (-o FILE)
+    bool profile = false; // count what each rule costs (-p, or -P FILE)
+    char *profileFile = NULL; // file to write the profile to instead of stderr
+    bool stream = false; // filter lines a chunk at a time, in constant memory (-s)
+    Ruleptr currentRulePtr = NULL; // pointer to current rule
 
     /* Argument checking
      * Ensure correct number and type of arguments
@@ -244,97 +647,175 @@ int main(int argc, char *argv[])
 	    exit(EXIT_FAILURE);
     }
 
-    if(argc < 4 || (argc-1)%3 > 0) {
-        exit(EXIT_FAILURE);
+    // options come before the rules; -- ends them (in case a FROM looks like one)
+    bool dashes = false; // the options ended with --
+    int maybeRule = 0; // first option that could instead have begun the rules
+    for(first = 1; first < argc; first++) {
+        if(strcmp(argv[first], "--") == 0) {
+            dashes = true;
+            first++;
+            break;
+        }
+        // whole rules from here on, the third argument a flags field?
+        if(!maybeRule && (argc - first) % 3 == 0 && argv[first+2][0] == '-')
+            maybeRule = first;
+        if(strcmp(argv[first], "-f") == 0 && first+1 < argc) {
+            ruleFile = argv[++first];
+            continue;
+        }
+        if(strcmp(argv[first], "-o") == 0 && first+1 < argc) {
+            outFile = argv[++first];
+            continue;
+        }
+        if(strcmp(argv[first], "-s") == 0) {
+            stream = true;
+            continue;
+        }
+        if(strcmp(argv[first], "-p") == 0) {
+            profile = true;
+            continue;
+        }
+        if(strcmp(argv[first], "-P") == 0 && first+1 < argc) {
+            profile = true;
+            profileFile = argv[++first];
+            continue;
+        }
+        if(!parseCount(argv[first], 'j', &numThreads) && !parseCount(argv[first], 'b', &batchSize)
+           && !parseSize(argv[first], 'c', &cacheSize))
+            break;
     }
+    if(!dashes && !ruleFile && maybeRule && maybeRule < first)
+        fprintf(stderr, "Subst16: warning: %s is taken as an option; put -- before the rules if it is a FROM\n",
+                argv[maybeRule]);
+    argc -= first-1;
+    argv += first-1;
+
+    Program prog = {NULL, 0, NULL, 0, NULL}; // the compiled rules
+
+    if(ruleFile) {
+        // rules come from the file instead of the command line
+        if(argc > 1)
+            exit(EXIT_FAILURE);
+        loadRules(ruleFile, &prog);
+    } else {
+        if(argc < 4 || (argc-1)%3 > 0) {
+            exit(EXIT_FAILURE);
+        }
 
-    // initialize rules array
-    memset(rules, 0, numRules * sizeof(Ruleptr));
+        prog.numRules = (argc-1)/3;
+        if(!(prog.code = malloc(prog.numRules * sizeof(Insn))))
+            DIE("malloc() failed");
 
-    /* Rule parsing 
-     * Creates an array of pointers to rules in order 
-     */
+        /* Rule parsing 
+         * Compiles the rules in order into a contiguous program
+         */
 	
-    for(i = 1; i < argc; i++) {
-        if(i % 3 == 1) {
-            /* error check for TO, make sure its a string and that it contains valid characters */
-            currentRulePtr = malloc(sizeof(Rule)); // create new rule
-	        currentRulePtr->FROM = argv[i];          
-        }
-        else if(i % 3 == 2) {
-            /* error check for TO, make sure its a string and that it contains valid characters */
-            currentRulePtr->TO = argv[i];
-        }
-        else if(i % 3 == 0) {
-            /* error check for flags - make sure it starts with a dash and has no spaces/odd characters */
-            parseFlags(argv[i], currentRulePtr);
-            rules[ruleIdx++] = currentRulePtr;
+        for(i = 1; i < argc; i++) {
+            if(i % 3 == 1) {
+                /* error check for TO, make sure its a string and that it contains valid characters */
+                currentRulePtr = &prog.code[(i-1)/3].rule; // next rule
+	            currentRulePtr->FROM = argv[i];          
+            }
+            else if(i % 3 == 2) {
+                /* error check for TO, make sure its a string and that it contains valid characters */
+                currentRulePtr->TO = argv[i];
+            }
+            else if(i % 3 == 0) {
+                /* error check for flags - make sure it starts with a dash and has no spaces/odd characters */
+                parseFlags(argv[i], currentRulePtr);
+                compileRule(currentRulePtr);
+            }
         }
     }
+    linkProgram(&prog);
 
-    /* Read from stdin and apply filters */
-    int j = 0;
-    currentRulePtr = rules[j];
-    char *input;
-    char *res = NULL;
-
-    while((input = getLine(stdin)) != NULL) {
-            if(input[strlen(input)-1] == '\n') input[strlen(input)-1] = '\0';
-            res = NULL;
-
-	       j = 0;
-
-            for(int i = 0; i < strlen(input) || j < numRules; i++) {
-                res = str_replace(input, currentRulePtr->FROM, currentRulePtr->TO, currentRulePtr->filter);
-
-                if (input && res && strcmp(input, res) == 0) {  // if no change
-                    if(currentRulePtr->onFailureRuleIndex < numRules && currentRulePtr->onFailureRuleIndex > -1) {
-                        if(currentRulePtr->onFailureRuleIndex > -1) {
-                            j = currentRulePtr->onFailureRuleIndex;
-                            currentRulePtr = rules[j];
-                        }
-                    } 
-                    // if no Sn or Fm rule specified, go to next rule if it exists
-                    else if(currentRulePtr->onFailureRuleIndex == -1 && j+1 < numRules) {
-		        currentRulePtr = rules[++j];
-			free(res);
-                    }
-                    else {
-                        break;
-                    }
-                } else if(res) {
-                    i = 0; // reset iterator
-                    if(currentRulePtr->onSuccessRuleIndex < numRules && currentRulePtr->onSuccessRuleIndex > -1) {
-                        if(currentRulePtr->onSuccessRuleIndex > -1) {
-                            j = currentRulePtr->onSuccessRuleIndex;
-                            currentRulePtr = rules[j];
-                        }
-                    } 
-                    // if no Sn or Fm rule specified, go to next rule if it exists
-                    else if(currentRulePtr->onSuccessRuleIndex == -1 && j+1 < numRules) {
-                        currentRulePtr = rules[++j];
-                    }
-                    else {
-                        break;
-                    }
-                    free(input);
-                    input = res;
-                }
+    // a precompiled program was checked when it was compiled
+    if(!prog.map)
+        checkProgram(&prog);
 
-            }
+    if(outFile) {
+        saveProgram(&prog, outFile);
+        freeProgram(&prog);
+        return EXIT_SUCCESS;
+    }
 
-        for(int idx = 0; res && idx < strlen(res); idx++) {
-            putchar(res[idx]);
+    if(stream) {
+        // streaming filters one line at a time as it is read, so it does not
+        // combine with threads, the cache, or profiling
+        if(numThreads > 1 || cacheSize || profile)
+            exit(EXIT_FAILURE);
+        if(!canStream(&prog))
+            DIE("Subst16: -s needs rules that are all -g or -q and do not jump on success or failure");
+        runStream(&prog, stdin, stdout);
+        freeProgram(&prog);
+        return EXIT_SUCCESS;
+    }
+
+    // more threads than processors can keep busy only cost memory and
+    // switching, and the output is the same with any number of them
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    if(cpus < 1)
+        cpus = 1;
+    if(numThreads > THREADS_PER_CPU * cpus)
+        numThreads = THREADS_PER_CPU * cpus;
+
+    /* Read from stdin and apply filters
+     * Each thread's buffers are reused for every line, so once they have
+     * grown to the longest line no more storage is allocated
+     */
+    Worker *workers = malloc(numThreads * sizeof(Worker));
+    if(!workers)
+        DIE("malloc() failed");
+    for(int t = 0; t < numThreads; t++) {
+        memset(&workers[t], 0, sizeof(Worker));
+        if(cacheSize)
+            workers[t].cache = createCache(cacheSize / numThreads);
+        if(profile)
+            workers[t].profile = createProfile(prog.numRules);
+    }
+
+    if(numThreads > 1) {
+        runParallel(&prog, workers, numThreads, batchSize);
+    } else {
+        while(readLine(&workers[0].cur, stdin)) {
+            filterLine(&prog, &workers[0]);
+            fwrite(workers[0].cur.data, 1, workers[0].cur.len, stdout);
+            putchar('\n');
         }
-        printf("\n");
+    }
 
-        free(res);
-        free(input);
+    long hits = 0, misses = 0; // cache statistics
+    for(int t = 0; t < numThreads; t++) {
+        free(workers[t].cur.data);
+        free(workers[t].tmp.data);
+        free(workers[t].key.data);
+        if(workers[t].cache) {
+            statsCache(workers[t].cache, &hits, &misses);
+            destroyCache(workers[t].cache);
+        }
+        if(t > 0 && profile) {
+            mergeProfile(workers[0].profile, workers[t].profile);
+            destroyProfile(workers[t].profile);
+        }
     }
-    // free rules
-    for(int r = 0; r < numRules; r++) {
-        free(rules[r]);
+    if(cacheSize)
+        fprintf(stderr, "Subst16: cache: %ld hits, %ld misses (%.1f%% hit rate)\n",
+                hits, misses, hits + misses ? 100.0 * hits / (hits + misses) : 0.0);
+
+    if(profile) {
+        FILE *fp = profileFile ? fopen(profileFile, "w") : stderr;
+        if(!fp) {
+            fprintf(stderr, "Subst16: cannot write %s\n", profileFile);
+            exit(EXIT_FAILURE);
+        }
+        printProfile(workers[0].profile, &prog, fp);
+        if(profileFile)
+            fclose(fp);
+        destroyProfile(workers[0].profile);
     }
 
+    free(workers);
+    freeProgram(&prog);
+
     return EXIT_SUCCESS;
 }
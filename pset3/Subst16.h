@@ -7,7 +7,23 @@
 #ifndef SUBST16_H
 #define SUBST16_H
 
+#include <stdio.h>
 #include <stdbool.h>
+#include <stddef.h>
+#include "Cache.h"
+
+// Print message to stderr and exit.
+#define DIE(msg) exit (fprintf (stderr, "%s\n", msg));
+
+/*
+ * Buffer: a growable string that is reused from line to line, so that
+ * once it is as long as the longest line nothing is malloc'd again.
+ */
+typedef struct buffer {
+	char *data;	/* the string, always null-terminated */
+	size_t len;	/* length of the string */
+	size_t cap;	/* bytes allocated for data */
+} Buffer;
 
 typedef struct rule {
  	char *FROM;
@@ -17,14 +33,109 @@ typedef struct rule {
 	int onFailureRuleIndex;
 	bool succeeded;
 	bool failed;
+
+	/* FROM and TO compiled once by compileRule() */
+	char *pattern;	/* FROM with @-escapes removed */
+	char *wild;	/* wild[i] is true if pattern[i] is an unescaped '.' */
+	int lenFrom;	/* length of pattern, which is also the length of every match */
+	int anchor;	/* index of first non-wildcard in pattern, -1 if none */
+	char *to;	/* TO with @-escapes and unescaped '^'s removed */
+	int lenTo;	/* length of to */
+	int *carets;	/* offsets in to at which the matched text is inserted */
+	int numCarets;	/* number of unescaped '^'s in TO */
+	int lenRep;	/* length of each replacement */
 } Rule;
 
 typedef struct rule *Ruleptr;
 
-char* StrStr(const char *str, const char *target);
-char *copylastn(char *dest,char *src,int n);
+/*
+ * Insn: one rule of a compiled program.  The jump targets are resolved to
+ * pointers into the same array, NULL meaning stop, so running the program
+ * needs no index or bounds checks.
+ */
+typedef struct insn {
+	Rule rule;
+	const struct insn *next[2];	/* next[false] on failure, next[true] on success */
+} Insn;
+
+typedef struct program {
+	Insn *code;	/* the rules, contiguous and in order */
+	int numRules;
+	void *map;	/* mapping of a precompiled rule file, or NULL */
+	size_t mapSize;	/* length of map */
+	char *text;	/* contents of a text rule file (FROMs and TOs point into it), or NULL */
+} Program;
+
+/*
+ * RuleStats: what one rule did while the program was profiled (-p)
+ */
+typedef struct ruleStats {
+	long invocations;
+	long successes;		/* invocations that changed the line */
+	long failures;		/* invocations that did not */
+	long long scanned;	/* bytes StrStr looked at */
+	long long replacements;	/* matches replaced */
+	long long nanoseconds;	/* time spent applying the rule */
+} RuleStats;
+
+#define STEP_BUCKETS 64	/* bucket k counts lines that took 2^k to 2^(k+1)-1 steps */
+
+/*
+ * Profile: one thread's counters while profiling, merged at exit
+ */
+typedef struct profile {
+	RuleStats *rules;		/* one per rule */
+	int numRules;
+	long lines;			/* lines the program ran on (not cache hits) */
+	long long steps;		/* rules applied to them */
+	long maxSteps;			/* most rules applied to one line */
+	long stepCounts[STEP_BUCKETS];	/* lines by number of steps */
+} Profile;
+
+void reserve(Buffer *buf, size_t n);
+void append(Buffer *buf, const char *src, size_t n);
+char* StrStr(const char *str, const char *end, const Rule *rule);
 void parseFlags(char *flags, Ruleptr ruleptr);
-char *str_replace(char *orig, char *from, char *to, char flag);
+void compileRule(Ruleptr ruleptr);
+bool putReplacement(char *dest, const Rule *rule, const char *match);
+bool applyRule(const Rule *rule, Buffer *cur, Buffer *tmp);
+bool readLine(Buffer *buf, FILE *fp);
+/*
+ * Worker: the state one thread needs to filter lines
+ */
+typedef struct worker {
+	Buffer cur;	/* the line being filtered */
+	Buffer tmp;	/* scratch space for applyRule */
+	Buffer key;	/* copy of the unfiltered line, when caching */
+	Cache cache;	/* maps lines to their filtered form, or NULL */
+	Profile *profile;	/* counters when profiling, or NULL */
+} Worker;
+
+void linkProgram(Program *prog);
+void checkProgram(const Program *prog);
+void runProgram(const Program *prog, Buffer *cur, Buffer *tmp);
+void profileProgram(const Program *prog, Worker *w);
+void freeProgram(Program *prog);
+void filterLine(const Program *prog, Worker *w);
+
+/* Rules.c */
+void loadRules(const char *path, Program *prog);
+void saveProgram(const Program *prog, const char *path);
+void unmapProgram(Program *prog);
+
+/* Profile.c */
+Profile *createProfile(int numRules);
+void countSteps(Profile *p, long steps);
+void mergeProfile(Profile *dst, const Profile *src);
+void printProfile(const Profile *p, const Program *prog, FILE *fp);
+void destroyProfile(Profile *p);
+
+/* Stream.c */
+bool canStream(const Program *prog);
+void runStream(const Program *prog, FILE *in, FILE *out);
+
+/* Parallel.c */
+void runParallel(const Program *prog, Worker workers[], int numThreads, int batchSize);
 
 #endif
 /* end SUBST16_H */
@@ -0,0 +1,151 @@
+/*
+File: SubstGen.c
+Programmer: Harrison Miller
+Description: generates rule sets and input corpora for benchmarking Subst16.
+
+    SubstGen rules KIND N SEED    prints N rules (FROM, TO, -FLAGS, one per line)
+    SubstGen input KIND N SEED    prints N lines of input
+
+Rule KINDs are literal, wild ('.' in FROM), caret ('^' in TO), g, q, r (all
+one filter), and jumps (random forward Sn/Fm targets).  Every generated
+program terminates: jumps only go forward, and an 'r' rule's replacement is
+always shorter than its match.
+
+Input KINDs are short (20-100 characters), long (8-16K characters), and dense
+(a three-letter alphabet, so nearly every position matches something).
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+// Print message to stderr and exit.
+#define DIE(msg) exit (fprintf (stderr, "%s\n", msg));
+
+static uint64_t state; /* xorshift64* generator state, so runs are repeatable everywhere */
+
+static unsigned randomInt(unsigned n)
+{
+    state ^= state >> 12;
+    state ^= state << 25;
+    state ^= state >> 27;
+    return (state * 0x2545f4914f6cdd1dULL >> 32) % n;
+}
+
+/*
+ * putWord: print a random word of LO to HI letters from the first K letters
+ * of the alphabet, with a '.' in place of each letter with probability WILD/8
+ */
+static void putWord(int lo, int hi, int k, int wild)
+{
+    int n = lo + randomInt(hi - lo + 1);
+
+    for (int i = 0; i < n; i++) {
+        if (randomInt(8) < (unsigned)wild)
+            putchar('.');
+        else if (randomInt(16) == 0)
+            fputs("@.", stdout); // an escaped, literal '.'
+        else
+            putchar('a' + randomInt(k));
+    }
+}
+
+/*
+ * putRule: print one rule
+ * kind: the rule set being generated
+ * index: index of the rule
+ * n: number of rules
+ */
+static void putRule(const char *kind, int index, int n)
+{
+    char filter = "gq"[randomInt(2)];
+    int wild = 0;
+
+    if (strcmp(kind, "g") == 0 || strcmp(kind, "q") == 0 || strcmp(kind, "r") == 0)
+        filter = kind[0];
+    else if (strcmp(kind, "jumps") == 0)
+        filter = "gqr"[randomInt(3)];
+    if (strcmp(kind, "wild") == 0 || strcmp(kind, "jumps") == 0)
+        wild = 2;
+
+    // half the FROMs use only the letters of the dense corpus
+    int k = randomInt(2) ? 3 : 6;
+
+    if (filter == 'r') {
+        // FROM of 3-5 characters, TO of at most 2, so every replacement shrinks the line
+        putWord(3, 5, k, wild);
+        putchar('\n');
+        putWord(0, 2, 8, 0);
+    } else {
+        putWord(2, 4, k, wild);
+        putchar('\n');
+        if (strcmp(kind, "caret") == 0 || (strcmp(kind, "jumps") == 0 && randomInt(3) == 0)) {
+            putchar('<');
+            putchar('^');
+            putWord(0, 2, 8, 0);
+            putchar('>');
+        } else {
+            putWord(0, 5, 8, 0);
+        }
+    }
+    printf("\n-%c", filter);
+
+    if (strcmp(kind, "jumps") == 0) {
+        if (index + 1 < n && randomInt(2))
+            printf("S%d", index + 1 + randomInt(n - index));
+        if (index + 1 < n && randomInt(2))
+            printf("F%d", index + 1 + randomInt(n - index));
+    }
+    putchar('\n');
+}
+
+/*
+ * putLine: print one line of input
+ */
+static void putLine(const char *kind)
+{
+    const char *alphabet = "abcdefghijklmnopqrstuvwxyz    ";
+    int len = 20 + randomInt(81);
+
+    if (strcmp(kind, "long") == 0) {
+        len = 8192 + randomInt(8193);
+    } else if (strcmp(kind, "dense") == 0) {
+        alphabet = "abc";
+        len = 40 + randomInt(161);
+    } else if (strcmp(kind, "short") != 0) {
+        DIE("SubstGen: unknown input kind");
+    }
+
+    for (int k = strlen(alphabet), i = 0; i < len; i++)
+        putchar(alphabet[randomInt(k)]);
+    putchar('\n');
+}
+
+int main(int argc, char *argv[])
+{
+    int n;
+
+    if (argc != 5)
+        DIE("usage: SubstGen rules|input KIND N SEED");
+    n = atoi(argv[3]);
+    state = 0x9e3779b97f4a7c15ULL * (strtoull(argv[4], NULL, 10) + 1);
+
+    if (strcmp(argv[1], "rules") == 0) {
+        const char *kinds[] = {"literal", "wild", "caret", "g", "q", "r", "jumps"};
+        int k;
+        for (k = 0; k < 7 && strcmp(argv[2], kinds[k]) != 0; k++)
+            ;
+        if (k == 7)
+            DIE("SubstGen: unknown rule kind");
+        for (int i = 0; i < n; i++)
+            putRule(argv[2], i, n);
+    } else if (strcmp(argv[1], "input") == 0) {
+        for (int i = 0; i < n; i++)
+            putLine(argv[2]);
+    } else {
+        DIE("usage: SubstGen rules|input KIND N SEED");
+    }
+
+    return EXIT_SUCCESS;
+}
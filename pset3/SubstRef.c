@@ -0,0 +1,200 @@
+/*
+File: SubstRef.c
+Programmer: Harrison Miller
+Description: reference implementation of Subst16 for differential testing.
+It is written to be obviously correct rather than fast: FROM and TO are
+interpreted character by character on every use, every replacement builds a
+new string, 'r' rescans from the start of the line after each replacement,
+and a rule succeeds if the line it produces differs from the line it was given.
+
+    SubstRef [FROM TO -FLAGS]*
+*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+
+// Print message to stderr and exit.
+#define DIE(msg) exit (fprintf (stderr, "%s\n", msg));
+
+/*
+ * patternLength: number of characters a match of FROM spans
+ */
+static size_t patternLength(const char *from)
+{
+    size_t n = 0;
+
+    for (; *from; from++, n++)
+        if (*from == '@' && from[1])
+            from++;
+    return n;
+}
+
+/*
+ * matchAt: whether FROM matches S at position I
+ */
+static bool matchAt(const char *s, size_t i, const char *from)
+{
+    for (; *from; from++, i++) {
+        if (!s[i])
+            return false;
+        if (*from == '@' && from[1]) {
+            if (s[i] != *++from)
+                return false;
+        } else if (*from != '.' && s[i] != *from) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/*
+ * find: index of the leftmost match of FROM in S at or after START, or -1
+ */
+static long find(const char *s, size_t start, const char *from)
+{
+    if (!*from)
+        return -1;
+    for (size_t i = start; s[i]; i++)
+        if (matchAt(s, i, from))
+            return i;
+    return -1;
+}
+
+/*
+ * replace: return a new string that is S with the N characters at position I
+ * replaced by TO, in which each '^' stands for those characters
+ */
+static char *replace(const char *s, size_t i, size_t n, const char *to)
+{
+    char *t = malloc(strlen(s) + strlen(to) * (n + 1) + 1);
+    size_t k = 0;
+
+    if (!t)
+        DIE("malloc() failed");
+    memcpy(t, s, i);
+    k = i;
+    for (; *to; to++) {
+        if (*to == '@' && to[1]) {
+            t[k++] = *++to;
+        } else if (*to == '^') {
+            memcpy(t + k, s + i, n);
+            k += n;
+        } else {
+            t[k++] = *to;
+        }
+    }
+    strcpy(t + k, s + i + n);
+    return t;
+}
+
+/*
+ * apply: apply one rule to *S, replacing *S with the result
+ * Returns true if the line changed
+ */
+static bool apply(char **s, const char *from, const char *to, char filter)
+{
+    size_t n = patternLength(from);
+    char *orig = *s, *t;
+    long i;
+    bool changed;
+
+    if (filter == 'r') {
+        changed = false;
+        while ((i = find(*s, 0, from)) >= 0) {
+            t = replace(*s, i, n, to);
+            if (strcmp(t, *s) == 0) {
+                free(t);
+                break;
+            }
+            free(*s);
+            *s = t;
+            changed = true;
+        }
+        return changed;
+    }
+
+    // replace the first match, then (for 'g') each later match that begins
+    // after the end of the replacement before it
+    *s = strdup(orig);
+    for (size_t start = 0; (i = find(*s, start, from)) >= 0; ) {
+        t = replace(*s, i, n, to);
+        start = strlen(t) - strlen(*s + i + n);
+        free(*s);
+        *s = t;
+        if (filter != 'g')
+            break;
+    }
+    changed = strcmp(orig, *s) != 0;
+    free(orig);
+    return changed;
+}
+
+/*
+ * target: the rule index named after flag letter C in FLAGS, or -1 if none
+ */
+static int target(const char *flags, char c)
+{
+    int index = -1;
+
+    for (; *flags; flags++)
+        if (*flags == c)
+            index = atoi(flags + 1);
+    return index;
+}
+
+/*
+ * filter: the filter letter named in FLAGS ('q' if none)
+ */
+static char filter(const char *flags)
+{
+    char f = 'q';
+
+    for (; *flags; flags++)
+        if (*flags == 'g' || *flags == 'q' || *flags == 'r')
+            f = *flags;
+    return f;
+}
+
+int main(int argc, char *argv[])
+{
+    int numRules = (argc - 1) / 3;
+    char buf[1 << 16];
+
+    if (argc < 4 || (argc - 1) % 3 > 0)
+        DIE("usage: SubstRef [FROM TO -FLAGS]*");
+
+    for (;;) {
+        // read a line of any length
+        char *s = NULL;
+        size_t len = 0;
+        while (fgets(buf, sizeof(buf), stdin)) {
+            size_t n = strlen(buf);
+            if (!(s = realloc(s, len + n + 1)))
+                DIE("realloc() failed");
+            memcpy(s + len, buf, n + 1);
+            len += n;
+            if (s[len-1] == '\n')
+                break;
+        }
+        if (!s)
+            break;
+        if (s[len-1] == '\n')
+            s[--len] = '\0';
+
+        for (int j = 0; j < numRules; ) {
+            char **rule = &argv[1 + 3*j];
+            bool changed = apply(&s, rule[0], rule[1], filter(rule[2]));
+            int next = target(rule[2], changed ? 'S' : 'F');
+            j = (next == -1) ? j + 1 : next;
+        }
+
+        printf("%s\n", s);
+        free(s);
+    }
+
+    return EXIT_SUCCESS;
+}
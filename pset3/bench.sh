@@ -0,0 +1,70 @@
+#!/bin/bash
+#
+#       Created by Harrison Miller
+#       Course CS223, Spring 2016
+#       Problem Set 3
+#
+#       bench.sh: throughput and differential correctness harness for Subst16
+#
+#       usage: ./bench.sh [REF]
+#
+#       For every corpus and rule set made by SubstGen, runs the reference
+#       implementation REF (default ./SubstRef) once, then times ./Subst16 in
+#       each mode, reporting lines/s and MB/s and whether its output matches
+#       REF's.  REF may be any other Subst16 binary, e.g. one built from an
+#       earlier revision.  Exits nonzero if any output differs.
+
+REF=${1:-./SubstRef}
+NRULES=${NRULES:-20}
+RULESETS=${RULESETS:-"literal wild caret g q r jumps"}
+CORPORA=${CORPORA:-"short:200000 long:20 dense:20000"}
+MODES=${MODES:-"serial -j4 -c16M"}
+
+TMP=$(mktemp -d)
+trap 'rm -rf "$TMP"' EXIT
+status=0
+
+# run PROGRAM ARGS... as ./Subst16, since Subst16 insists on that name
+run() {
+    local prog=$1
+    shift
+    (exec -a ./Subst16 "$prog" "$@")
+}
+
+now() {
+    date +%s%N
+}
+
+printf "%-8s %-8s %-10s %12s %10s  %s\n" corpus rules mode lines/s MB/s output
+for corpus in $CORPORA; do
+    kind=${corpus%%:*}
+    n=${corpus##*:}
+    ./SubstGen input "$kind" "$n" 1 > "$TMP/in"
+    bytes=$(wc -c < "$TMP/in")
+
+    for ruleset in $RULESETS; do
+        mapfile -t rules < <(./SubstGen rules "$ruleset" "$NRULES" 1)
+        run "$REF" "${rules[@]}" < "$TMP/in" > "$TMP/expected" 2>/dev/null
+
+        for mode in $MODES; do
+            opts=()
+            [ "$mode" != serial ] && opts=($mode)
+            start=$(now)
+            run ./Subst16 "${opts[@]}" -- "${rules[@]}" < "$TMP/in" > "$TMP/out" 2>/dev/null
+            end=$(now)
+
+            if cmp -s "$TMP/out" "$TMP/expected"; then
+                result=ok
+            else
+                result=DIFFERS
+                status=1
+            fi
+            awk -v c="$kind" -v r="$ruleset" -v m="$mode" -v l="$n" -v b="$bytes" \
+                -v ns=$((end - start)) -v res="$result" 'BEGIN {
+                s = ns / 1e9
+                printf "%-8s %-8s %-10s %12.0f %10.1f  %s\n", c, r, m, l / s, b / s / 1e6, res
+            }'
+        done
+    done
+done
+exit $status
@@ -0,0 +1,199 @@
+/******************************************************************************
+ * ConcQueue.c
+ * Bounded lock-free queues of strings that threads can share
+ *
+ * Both queues are rings of 2^k slots indexed by counters that only grow, so
+ * slot i%2^k is found by masking and the counters never need resetting.
+ *
+ * SpscQueue is Lamport's ring.  The producer alone writes tail and the
+ * consumer alone writes head; each publishes its counter with a release
+ * store after touching the slot, and reads the other's with an acquire load,
+ * and only when its cached copy says the ring is full (or empty), so most
+ * calls touch no shared cache line but the slot's.
+ *
+ * MpmcQueue is Dmitry Vyukov's ring.  Each slot has a sequence number that
+ * says whose turn it is: a producer may fill slot i%2^k when its sequence is
+ * i, and a consumer may empty it when its sequence is i+1.  Producers (and
+ * consumers) claim positions by compare-and-swap on a shared counter, then
+ * hand the slot on by storing its next sequence number.
+ *
+ * The counters are padded apart so that producers and consumers do not share
+ * a cache line.  The atomics are GCC's __atomic builtins, as the code is C99.
+ *
+ * Harrison Miller
+ ******************************************************************************/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <sched.h>
+#include <time.h>
+
+#include "ConcQueue.h"
+
+#define CACHE_LINE 64
+#define SPINS 64                // yields before backoff() starts sleeping
+
+struct spscQueue {
+    char **slot;
+    size_t mask;                // slots - 1
+    char pad0[CACHE_LINE];
+    size_t head;                // strings removed; written by the consumer
+    size_t tailCache;           // the consumer's last look at tail
+    char pad1[CACHE_LINE];
+    size_t tail;                // strings added; written by the producer
+    size_t headCache;           // the producer's last look at head
+    char pad2[CACHE_LINE];
+};
+
+typedef struct cell {
+    size_t seq;                 // whose turn it is (see above)
+    char *data;
+} Cell;
+
+struct mpmcQueue {
+    Cell *cell;
+    size_t mask;
+    char pad0[CACHE_LINE];
+    size_t tail;                // positions claimed by producers
+    char pad1[CACHE_LINE];
+    size_t head;                // positions claimed by consumers
+    char pad2[CACHE_LINE];
+};
+
+// Return the least power of two that is at least N (and at least 2).
+
+static size_t roundUp(size_t n) {
+    size_t size = 2;
+
+    while(size < n) {
+        size *= 2;
+    }
+    return size;
+}
+
+SpscQueue createSpsc(size_t size) {
+    SpscQueue q = malloc(sizeof(*q));
+
+    size = roundUp(size);
+    if(!q || !(q->slot = malloc(size * sizeof(char*)))) {
+        free(q);
+        return NULL;
+    }
+    q->mask = size - 1;
+    q->head = q->tail = q->tailCache = q->headCache = 0;
+    return q;
+}
+
+bool addSpsc(SpscQueue q, char *s) {
+    size_t tail = q->tail;      // only this thread writes it
+
+    if(tail - q->headCache > q->mask) {
+        q->headCache = __atomic_load_n(&q->head, __ATOMIC_ACQUIRE);
+        if(tail - q->headCache > q->mask) {
+            return false;
+        }
+    }
+    q->slot[tail & q->mask] = s;
+    __atomic_store_n(&q->tail, tail + 1, __ATOMIC_RELEASE);
+    return true;
+}
+
+bool removeSpsc(SpscQueue q, char **s) {
+    size_t head = q->head;      // only this thread writes it
+
+    if(head == q->tailCache) {
+        q->tailCache = __atomic_load_n(&q->tail, __ATOMIC_ACQUIRE);
+        if(head == q->tailCache) {
+            return false;
+        }
+    }
+    *s = q->slot[head & q->mask];
+    __atomic_store_n(&q->head, head + 1, __ATOMIC_RELEASE);
+    return true;
+}
+
+void destroySpsc(SpscQueue q) {
+    free(q->slot);
+    free(q);
+}
+
+MpmcQueue createMpmc(size_t size) {
+    MpmcQueue q = malloc(sizeof(*q));
+
+    size = roundUp(size);
+    if(!q || !(q->cell = malloc(size * sizeof(Cell)))) {
+        free(q);
+        return NULL;
+    }
+    for(size_t i = 0; i < size; i++) {
+        q->cell[i].seq = i;
+    }
+    q->mask = size - 1;
+    q->head = q->tail = 0;
+    return q;
+}
+
+bool addMpmc(MpmcQueue q, char *s) {
+    size_t pos = __atomic_load_n(&q->tail, __ATOMIC_RELAXED);
+    Cell *cell;
+
+    for(;;) {
+        intptr_t dif;
+        cell = &q->cell[pos & q->mask];
+        dif = (intptr_t)__atomic_load_n(&cell->seq, __ATOMIC_ACQUIRE) - (intptr_t)pos;
+        if(dif == 0) {
+            if(__atomic_compare_exchange_n(&q->tail, &pos, pos + 1, true,
+                                           __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                break;
+            }                                   // lost the race: pos reloaded
+        } else if (dif < 0) {
+            return false;                       // a lap behind: full
+        } else {
+            pos = __atomic_load_n(&q->tail, __ATOMIC_RELAXED);
+        }
+    }
+    cell->data = s;
+    __atomic_store_n(&cell->seq, pos + 1, __ATOMIC_RELEASE);
+    return true;
+}
+
+bool removeMpmc(MpmcQueue q, char **s) {
+    size_t pos = __atomic_load_n(&q->head, __ATOMIC_RELAXED);
+    Cell *cell;
+
+    for(;;) {
+        intptr_t dif;
+        cell = &q->cell[pos & q->mask];
+        dif = (intptr_t)__atomic_load_n(&cell->seq, __ATOMIC_ACQUIRE) - (intptr_t)(pos + 1);
+        if(dif == 0) {
+            if(__atomic_compare_exchange_n(&q->head, &pos, pos + 1, true,
+                                           __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                break;
+            }
+        } else if (dif < 0) {
+            return false;                       // not filled yet: empty
+        } else {
+            pos = __atomic_load_n(&q->head, __ATOMIC_RELAXED);
+        }
+    }
+    *s = cell->data;
+    __atomic_store_n(&cell->seq, pos + q->mask + 1, __ATOMIC_RELEASE);
+    return true;
+}
+
+void destroyMpmc(MpmcQueue q) {
+    free(q->cell);
+    free(q);
+}
+
+void backoff(int *spins) {
+    if(++*spins < SPINS) {
+        sched_yield();
+    } else {
+        struct timespec t = {0, 50000};         // 50us
+        nanosleep(&t, NULL);
+    }
+}
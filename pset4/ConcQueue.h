@@ -0,0 +1,49 @@
+/******************************************************************************
+ * ConcQueue.h
+ * Bounded lock-free queues of strings that threads can share
+ *
+ * Like the Queue ADT, these hold char pointers in FIFO order, but with room
+ * for a fixed number of them (rounded up to a power of two), and adding and
+ * removing never block: they return false when the queue is full or empty,
+ * and the caller decides how to wait.
+ *
+ *   SpscQueue   one thread adds and one thread removes
+ *   MpmcQueue   any number of threads add and remove
+ *
+ * Harrison Miller
+ ******************************************************************************/
+
+#ifndef CONCQUEUE_H
+#define CONCQUEUE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+typedef struct spscQueue *SpscQueue;
+typedef struct mpmcQueue *MpmcQueue;
+
+// Return a queue with room for at least SIZE strings, or NULL if there is no
+// memory for it.
+SpscQueue createSpsc(size_t size);
+MpmcQueue createMpmc(size_t size);
+
+// Add S at the tail of Q and return true, or return false if Q is full.
+bool addSpsc(SpscQueue q, char *s);
+bool addMpmc(MpmcQueue q, char *s);
+
+// Remove the string at the head of Q into *S and return true, or return
+// false if Q is empty.
+bool removeSpsc(SpscQueue q, char **s);
+bool removeMpmc(MpmcQueue q, char **s);
+
+// Free the storage used by Q (but not the strings in it).  No other thread
+// may be using Q.
+void destroySpsc(SpscQueue q);
+void destroyMpmc(MpmcQueue q);
+
+// Wait a little for another thread, the longer the more times *SPINS says
+// this thread has waited already.
+void backoff(int *spins);
+
+#endif
+/* end CONCQUEUE_H */
@@ -0,0 +1,158 @@
+/******************************************************************************
+ * Ingest.c
+ * The lines of Merge16's input files, in order
+ *
+ * Without -p the files are read (or mapped, with -z) one after another by
+ * the thread that asks for their lines.  With -p, up to MAX_PRODUCERS
+ * threads read them ahead, each taking the next file not yet taken and
+ * passing its lines through that file's own SpscQueue, with NULL after the
+ * last; the consumer takes them from the queues in file order, so the lines
+ * come out in the same order either way.  While the consumer is busy sorting
+ * or writing a run, the producers go on reading, until each file's queue is
+ * full, so slow input is read while the sort proceeds.
+ *
+ * HWK #4
+ * Merging Queues
+ *
+ * Harrison Miller
+ ******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <pthread.h>
+
+#include "/c/cs223/Hwk4/Queue.h"
+#include "Merge16.h"
+#include "ConcQueue.h"
+
+#define MAX_PRODUCERS 16        // most files read at once with -p
+#define QUEUE_LINES 65536       // lines each file may be read ahead
+
+struct ingest {
+    FILE **fp;                  // the files
+    int n;
+    int pos, len;               // the key of their lines
+    int cur;                    // the file lines are being taken from
+    bool zeroCopy;              // map files when possible (without -p)
+    bool started;               // fp[cur] has been opened (without -p)
+    bool mapped;                // and is mapped, with *p to *end left
+    const char *p, *end;
+    char *buf;                  // for readLine() (without -p)
+    size_t cap;
+    int producers;              // threads reading ahead, or 0
+    pthread_t *tid;
+    SpscQueue *queue;           // queue[f] holds the lines of fp[f]
+    int next;                   // the next file a producer may take
+};
+
+// Read whole files into their queues, one after another, until none are
+// left to take.
+
+static void *produce(void *arg) {
+    Ingest g = arg;
+    char *buf = NULL;
+    size_t cap = 0;
+    int f;
+
+    while((f = __atomic_fetch_add(&g->next, 1, __ATOMIC_RELAXED)) < g->n) {
+        char *line;
+        bool more = true;
+
+        while(more) {
+            int spins = 0;
+            line = readLine(g->fp[f], &buf, &cap, g->pos, g->len);
+            more = (line != NULL);
+            while(!addSpsc(g->queue[f], line)) {
+                backoff(&spins);
+            }
+        }
+        fclose(g->fp[f]);
+    }
+    free(buf);
+    return NULL;
+}
+
+// Return the lines of the N files FP[0..N-1] (an array it frees), keyed by POS
+// and LEN, read ahead by a thread per file (at most MAX_PRODUCERS) if
+// PIPELINE, or else mapped if ZEROCOPY.
+
+Ingest createIngest(FILE **fp, int n, int pos, int len, bool pipeline, bool zeroCopy) {
+    Ingest g = malloc(sizeof(*g));
+
+    if(!g) {
+        DIE("malloc() failed");
+    }
+    *g = (struct ingest){fp, n, pos, len, 0, zeroCopy, false, false, NULL, NULL, NULL, 0,
+                         0, NULL, NULL, 0};
+    if(!pipeline || n == 0) {
+        return g;
+    }
+
+    g->producers = n < MAX_PRODUCERS ? n : MAX_PRODUCERS;
+    if(!(g->tid = malloc(g->producers * sizeof(pthread_t)))
+       || !(g->queue = malloc(n * sizeof(SpscQueue)))) {
+        DIE("malloc() failed");
+    }
+    for(int f = 0; f < n; f++) {
+        if(!(g->queue[f] = createSpsc(QUEUE_LINES))) {
+            DIE("createSpsc() failed");
+        }
+    }
+    for(int t = 0; t < g->producers; t++) {
+        if(pthread_create(&g->tid[t], NULL, produce, g) != 0) {
+            DIE("pthread_create() failed");
+        }
+    }
+    return g;
+}
+
+// Return the next line of G's files, or NULL after the last.
+
+char *nextIngest(Ingest g) {
+    char *line;
+
+    while(g->cur < g->n) {
+        FILE *fp = g->fp[g->cur];
+
+        if(g->producers > 0) {
+            int spins = 0;
+            while(!removeSpsc(g->queue[g->cur], &line)) {
+                backoff(&spins);
+            }
+        } else {
+            if(!g->started) {
+                g->mapped = g->zeroCopy && mapFile(fp, &g->p, &g->end);
+                g->started = true;
+            }
+            line = g->mapped ? mapLine(&g->p, g->end, g->pos, g->len)
+                             : readLine(fp, &g->buf, &g->cap, g->pos, g->len);
+            if(!line) {
+                fclose(fp);
+                g->started = false;
+            }
+        }
+
+        if(line) {
+            return line;
+        }
+        g->cur++;                           // that file is done
+    }
+    return NULL;
+}
+
+// Wait for G's threads and free it.  Every line must have been taken.
+
+void destroyIngest(Ingest g) {
+    for(int t = 0; t < g->producers; t++) {
+        pthread_join(g->tid[t], NULL);
+    }
+    for(int f = 0; g->queue && f < g->n; f++) {
+        destroySpsc(g->queue[f]);
+    }
+    free(g->queue);
+    free(g->tid);
+    free(g->buf);
+    free(g->fp);
+    free(g);
+}
@@ -0,0 +1,255 @@
+/******************************************************************************
+ * Line.c
+ * Lines with precomputed sort keys
+ *
+ * Each line has a header describing its key: where the key starts, how long
+ * it is, and its first 8 bytes packed big-endian into an integer (zero-padded;
+ * a key never contains a null).  Comparing two lines is then one integer
+ * comparison unless their keys share their first 8 bytes.
+ *
+ * A line read from a stream is copied into one block with its header.  With
+ * -z a regular file is instead mapped into memory whole, and each line is a
+ * header pointing at its text in the mapping: Merge16 only reorders lines, so
+ * they never need copying, and the headers are handed out from an arena
+ * rather than malloc()ed one by one.
+ *
+ * HWK #4
+ * Merging Queues
+ *
+ * Harrison Miller
+ ******************************************************************************/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "/c/cs223/Hwk4/Queue.h"
+#include "Merge16.h"
+
+#define ARENA_LINES 4096        // headers of mapped lines per arena block
+
+// The files mapFile() has mapped.
+static struct mapping {
+    void *addr;
+    size_t size;
+} *maps = NULL;
+static int numMaps = 0;
+
+// The arena: blocks of ARENA_LINES headers, each followed by its Slice, of
+// which block curBlock is being handed out and the first used are taken.
+#define MAPPED_SIZE (sizeof(Line) + sizeof(Slice))
+static char **blocks = NULL;
+static int numBlocks = 0, curBlock = -1;
+static size_t used = ARENA_LINES;
+
+// Set the key of LINE, whose text is the N characters at TEXT, to the LEN
+// characters starting at position POS.
+
+static void setKey(Line *line, const char *text, size_t n, int pos, int len) {
+    size_t off = (size_t)pos < n ? (size_t)pos : n;
+    size_t keyLen = (n - off < (size_t)len) ? n - off : (size_t)len;
+    uint64_t prefix = 0;
+
+    for(size_t i = 0; i < 8; i++) {
+        prefix = (prefix << 8) | (i < keyLen ? (unsigned char)text[off + i] : 0);
+    }
+    line->prefix = prefix;
+    line->keyOff = off;
+    line->keyLen = keyLen;
+}
+
+// Return a new line holding the N characters at S, with the key of LEN
+// characters starting at position POS.
+
+char *newLine(const char *s, size_t n, int pos, int len) {
+    Line *line;
+
+    if(n > UINT32_MAX) {
+        DIE("line too long");
+    }
+    if(!(line = malloc(sizeof(Line) + n + 1))) {
+        DIE("malloc() failed");
+    }
+    memcpy(line->text, s, n);
+    line->text[n] = '\0';
+    line->mapped = false;
+
+    setKey(line, s, n, pos, len);
+    return (char*)line;
+}
+
+// Return a new line, not mapped, with the same text and key as S.
+
+char *copyLine(const char *s) {
+    const Line *line = LINE(s);
+    const char *text = TEXT(line);
+    size_t n = line->mapped ? ((const Slice*)line->text)->len : strlen(text);
+    Line *copy;
+
+    if(!(copy = malloc(sizeof(Line) + n + 1))) {
+        DIE("malloc() failed");
+    }
+    *copy = *line;
+    memcpy(copy->text, text, n);
+    copy->text[n] = '\0';
+    copy->mapped = false;
+    return (char*)copy;
+}
+
+// Free a line made by newLine().  A mapped line's header belongs to the arena
+// and is reclaimed by releaseLines().
+
+void freeLine(char *s) {
+    if(!LINE(s)->mapped) {
+        free(LINE(s));
+    }
+}
+
+// Read the next line of FP, without its newline, into a new line keyed by POS
+// and LEN.  *BUF and *CAP are a buffer for getline() that the caller keeps
+// from call to call.  Return NULL at end of file.
+
+char *readLine(FILE *fp, char **buf, size_t *cap, int pos, int len) {
+    ssize_t n = getline(buf, cap, fp);
+
+    if(n < 0) {
+        return NULL;
+    }
+    // the line ends at its first newline, carriage return or null
+    return newLine(*buf, strcspn(*buf, "\r\n"), pos, len);
+}
+
+// Map the file FP into memory and set *START and *END to the ends of its
+// contents (both NULL if it is empty).  Return false if it is not a regular
+// file, or cannot be mapped, and must be read instead.
+
+bool mapFile(FILE *fp, const char **start, const char **end) {
+    struct stat st;
+    void *addr;
+
+    if(fstat(fileno(fp), &st) != 0 || !S_ISREG(st.st_mode)) {
+        return false;
+    }
+    if(st.st_size == 0) {
+        *start = *end = NULL;
+        return true;
+    }
+    addr = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fileno(fp), 0);
+    if(addr == MAP_FAILED) {
+        return false;
+    }
+    if(!(maps = realloc(maps, (numMaps + 1) * sizeof(*maps)))) {
+        DIE("realloc() failed");
+    }
+    maps[numMaps].addr = addr;
+    maps[numMaps++].size = st.st_size;
+
+    *start = addr;
+    *end = *start + st.st_size;
+    return true;
+}
+
+// Return the line of a mapped file that starts at *P (before END), keyed by
+// POS and LEN, and move *P past its newline; the line is its text up to the
+// first newline, carriage return or null, as with readLine().  Return NULL if
+// *P is END.
+
+char *mapLine(const char **p, const char *end, int pos, int len) {
+    const char *s = *p, *nl;
+    size_t n;
+    Line *line;
+
+    if(s == end) {
+        return NULL;
+    }
+    nl = memchr(s, '\n', end - s);
+    *p = nl ? nl + 1 : end;
+    n = (nl ? nl : end) - s;
+    for(size_t i = 0; i < n; i++) {
+        if(s[i] == '\r' || s[i] == '\0') {
+            n = i;
+            break;
+        }
+    }
+    if(n > UINT32_MAX) {
+        DIE("line too long");
+    }
+
+    if(used == ARENA_LINES) {
+        if(++curBlock == numBlocks) {
+            if(!(blocks = realloc(blocks, (numBlocks + 1) * sizeof(char*)))
+               || !(blocks[numBlocks++] = malloc(ARENA_LINES * MAPPED_SIZE))) {
+                DIE("malloc() failed");
+            }
+        }
+        used = 0;
+    }
+    line = (Line*)(blocks[curBlock] + used++ * MAPPED_SIZE);
+    *(Slice*)line->text = (Slice){s, n};
+    line->mapped = true;
+
+    setKey(line, s, n, pos, len);
+    return (char*)line;
+}
+
+// Take back the headers of every mapped line, for lines mapped from now on.
+// No mapped line may be in use any more.
+
+void releaseLines(void) {
+    curBlock = -1;
+    used = ARENA_LINES;
+}
+
+// Unmap every file mapFile() has mapped and free the arena.  No mapped line
+// may be in use any more.
+
+void unmapFiles(void) {
+    for(int i = 0; i < numMaps; i++) {
+        munmap(maps[i].addr, maps[i].size);
+    }
+    for(int i = 0; i < numBlocks; i++) {
+        free(blocks[i]);
+    }
+    free(maps);
+    free(blocks);
+    maps = NULL;
+    blocks = NULL;
+    numMaps = numBlocks = 0;
+    releaseLines();
+}
+
+// Write the line S to FP, followed by a newline.
+
+void putLine(const char *s, FILE *fp) {
+    const Line *line = LINE(s);
+
+    if(line->mapped) {
+        fwrite(((const Slice*)line->text)->text, 1, ((const Slice*)line->text)->len, fp);
+    } else {
+        fputs(line->text, fp);
+    }
+    putc('\n', fp);
+}
+
+// Compare the keys of two lines like strcmp(): the key that is less in the
+// first byte where they differ, or else is shorter, comes first.
+
+int compareLines(const char *s1, const char *s2) {
+    const Line *a = LINE(s1), *b = LINE(s2);
+    uint32_t n;
+    int cmp;
+
+    if(a->prefix != b->prefix) {
+        return a->prefix < b->prefix ? -1 : 1;
+    }
+    n = a->keyLen < b->keyLen ? a->keyLen : b->keyLen;
+    if(n > 8 && (cmp = memcmp(TEXT(a) + a->keyOff + 8, TEXT(b) + b->keyOff + 8, n - 8))) {
+        return cmp;
+    }
+    return (a->keyLen > b->keyLen) - (a->keyLen < b->keyLen);
+}
@@ -0,0 +1,118 @@
+/******************************************************************************
+ * LoserTree.c
+ * Tournament (loser) tree for merging K sorted sources at once
+ *
+ * The sources are the leaves of a binary tree.  Each internal node remembers
+ * the source that lost the match played there, and node 0 the overall winner,
+ * whose line is the least.  When the winner's source moves on to its next
+ * line, only the matches on the path from its leaf to the root are replayed,
+ * so each line out costs about log2(K) comparisons.
+ *
+ * Lines are compared by key, and lines with equal keys by source index, so
+ * merging runs that are in input order is stable.  An exhausted source loses
+ * to every other.
+ *
+ * HWK #4
+ * Merging Queues
+ *
+ * Harrison Miller
+ ******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+
+#include "/c/cs223/Hwk4/Queue.h"
+#include "Merge16.h"
+
+struct loserTree {
+    int k;                  // number of sources
+    int *loser;             // loser[p] for internal node p, loser[0] the winner
+    char **head;            // current line of each source, NULL once exhausted
+};
+
+// Return true if source A's line comes before source B's.
+
+static bool beats(LoserTree t, int a, int b) {
+    int cmp;
+
+    if(!t->head[a]) {
+        return false;
+    }
+    if(!t->head[b]) {
+        return true;
+    }
+    cmp = compareLines(t->head[a], t->head[b]);
+    return cmp < 0 || (cmp == 0 && a < b);
+}
+
+// Return a tree over K sources whose first lines are HEADS[0..K-1] (NULL for
+// an empty source).
+
+LoserTree createTree(char **heads, int k) {
+    LoserTree t = malloc(sizeof(*t));
+    int *win;               // winner at each node while building; leaves at k..2k-1
+
+    if(!t || !(t->loser = malloc(k * sizeof(int))) || !(t->head = malloc(k * sizeof(char*)))
+       || !(win = malloc(2 * k * sizeof(int)))) {
+        DIE("malloc() failed");
+    }
+    t->k = k;
+
+    for(int i = 0; i < k; i++) {
+        t->head[i] = heads[i];
+        win[k + i] = i;
+    }
+    for(int p = k - 1; p >= 1; p--) {
+        int a = win[2*p], b = win[2*p + 1];
+        if(beats(t, a, b)) {
+            win[p] = a;
+            t->loser[p] = b;
+        } else {
+            win[p] = b;
+            t->loser[p] = a;
+        }
+    }
+    t->loser[0] = (k > 1) ? win[1] : 0;
+
+    free(win);
+    return t;
+}
+
+// Return the index of the source with the least line and store that line in
+// *S, or return -1 if every source is exhausted.
+
+int winnerTree(LoserTree t, char **s) {
+    int w = t->loser[0];
+
+    if(!t->head[w]) {
+        return -1;
+    }
+    *s = t->head[w];
+    return w;
+}
+
+// Replace the winner's line with S, the next line of its source (NULL if it
+// has no more), and replay its matches.
+
+void replaceTree(LoserTree t, char *s) {
+    int w = t->loser[0];
+
+    t->head[w] = s;
+    for(int p = (w + t->k) / 2; p >= 1; p /= 2) {
+        if(beats(t, t->loser[p], w)) {
+            int tmp = t->loser[p];
+            t->loser[p] = w;
+            w = tmp;
+        }
+    }
+    t->loser[0] = w;
+}
+
+// Free the storage used by a tree (but not the lines).
+
+void destroyTree(LoserTree t) {
+    free(t->loser);
+    free(t->head);
+    free(t);
+}
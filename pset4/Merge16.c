@@ -2,6 +2,41 @@
  * Merge16.c
  * Main routine for sorting two queues
  *
+ *   Merge16 [-POS[,LEN]] [-M SIZE] [-j N] [-e merge|radix] [-z] [-p] [-k K]
+ *           [-m [-c]] [filename]*
+ *
+ * Sorts the lines of the files by the LEN characters starting at position POS
+ * (0 and the rest of the line by default), keeping lines with equal keys in
+ * the order they were read.  The key applies to every file, wherever it
+ * appears among them.
+ *
+ * With -M, at most about SIZE bytes (a number with an optional K, M or G) of
+ * lines are held at once: each time that much has been read, it is sorted and
+ * written to a temporary file as a run, and the runs are merged at the end
+ * (and in groups along the way, so that only a few hundred are open at once;
+ * see Runs.c).
+ *
+ * With -j, the lines held in memory are sorted with N threads (see
+ * ParallelSort.c); the output is the same.
+ *
+ * With -e radix, they are sorted by MSD radix sort (see Radix.c) rather than
+ * merge sort, which looks at fewer bytes when many keys share long prefixes.
+ *
+ * With -z, regular files are mapped into memory rather than read, and lines
+ * are sorted and written where they lie in the mapping (see Line.c).
+ *
+ * With -k, only the first K lines of the output are printed, and only they
+ * are kept as the lines are read (see TopK.c); -M, -j and -e do not apply.
+ *
+ * With -p, the files are read ahead by threads of their own while the lines
+ * already read are sorted (see Ingest.c).  It cannot be used with -z.
+ *
+ * With -m, the files must each be sorted already, and are merged rather than
+ * sorted, holding one line per file (see mergeFiles() in Runs.c); -M, -j, -e,
+ * -z and -p do not apply, and -k cannot be used.  With -c as well, Merge16
+ * stops with an error at the first line whose key is less than the one before
+ * it in its file.
+ *
  * HWK #4
  * Merging Queues
  *
@@ -13,69 +48,233 @@
 #include <ctype.h>
 #include <limits.h>
 #include <string.h>
+#include <stdbool.h>
 
-#include "/c/cs223/Hwk3/getLine.h"
 #include "/c/cs223/Hwk4/Queue.h"
+#include "QueueExt.h"
 #include "Merge16.h"
 
-#define ADDQ(Q,S) if(!addQ(Q,S)) DIE("addQ() failed");
-#define CREATEQ(Q) if(!createQ(Q)) DIE("createQ() failed");
-#define HEADQ(Q) if(!headQ(Q, S)) DIE("headQ() failed");
-#define ISEMPTYQ(Q) return isEmptyQ(Q)
-#define REMOVEQ(Q,S) if(!removeQ(Q,S)) DIE("removeQ() failed");
-#define DESTROYQ(Q) if(!destroyQ(Q))) DIE("destroyQ() failed"); 
+#define LINE_OVERHEAD 32        // bytes a queued line costs besides its Line:
+                                // malloc's header and rounding, and queue slots
+#define RUN_LINES 32            // fewest lines in a run sortQueue() starts with
+#define MAX_WAYS 1024           // most queues sortQueue() merges at once
+#define OUT_BUFFER (1 << 20)    // bytes of stdout buffer with -z
+
+// Merge the K sorted queues RUNS[0..K-1] into *OUT with a loser tree, taking
+// lines with equal keys from the earlier run first, and destroy them.  Once
+// all runs but one are exhausted, the rest of that one is appended to *OUT
+// whole.
+
+static void mergeQueues(Queue runs[], int k, Queue *out) {
+    char **heads = malloc(k * sizeof(char*));
+    int live = 0;                           // runs not yet exhausted
+    LoserTree t;
+    char *s;
+    int i;
+
+    if(!heads) {
+        DIE("malloc() failed");
+    }
+    for(i = 0; i < k; i++) {
+        if(!removeQ(&runs[i], &heads[i])) {
+            heads[i] = NULL;
+        } else {
+            live++;
+        }
+    }
+    t = createTree(heads, k);
+
+    while(live > 1 && (i = winnerTree(t, &s)) >= 0) {
+        ADDQ(out, s);
+        if(!removeQ(&runs[i], &s)) {
+            s = NULL;
+            live--;
+        }
+        replaceTree(t, s);
+    }
+    if(live == 1) {
+        i = winnerTree(t, &s);
+        ADDQ(out, s);
+        APPENDQ(out, &runs[i]);
+    }
 
-void removeNewline(char *s) {
-    while(*s && *s != '\n' && *s != '\r') s++;
-    *s = 0;
+    destroyTree(t);
+    for(i = 0; i < k; i++) {
+        DESTROYQ(&runs[i]);
+    }
+    free(heads);
 }
 
-// Custom strcmp that compares keys
-int Strcmp(const char *s1, const char *s2, int pos, int len) {
-if(pos > strlen(s1)) {
- s1 = &s1[strlen(s1)];
-} else {
- s1 = s1+pos;
+// Insert LINE into the sorted lines BLOCK[0..M-1], after any with an equal key.
+
+static void insertLine(char **block, long m, char *line) {
+    long lo = 0, hi = m;
+
+    while(lo < hi) {                        // first key greater than line's
+        long mid = (lo + hi) / 2;
+        if(compareLines(block[mid], line) <= 0) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    memmove(&block[lo + 1], &block[lo], (m - lo) * sizeof(char*));
+    block[lo] = line;
+}
+
+// Sort the N lines in *Q by key.  They are cut into natural runs as they are
+// taken from *Q, as in Timsort: each run is the longest stretch of lines in
+// nondecreasing order, or in strictly decreasing order (which is reversed;
+// strictly, so that reversing never reorders equal keys).  A run shorter than
+// RUN_LINES is extended to that length by binary insertion.  Each run goes in
+// its own queue, and the runs are merged in one pass with a loser tree (two if
+// there are more than MAX_WAYS of them); sorted input is a single run and is
+// not merged at all.  Insertion goes after equal keys and the tree takes equal
+// keys from the earlier run, so the sort is stable.
+
+void sortQueue(Queue *q, long n) {
+    Queue *runs = NULL;
+    long k = 0, maxRuns = 0;                // runs, and room for them
+    char **block = NULL;                    // the run being formed
+    long maxBlock = 0;
+    char *line;
+
+    while(n > 0) {
+        long m = 0;
+        bool descending = false;            // set by the first two lines
+
+        for(;;) {
+            if(m == maxBlock) {
+                maxBlock = maxBlock ? 2 * maxBlock : 2 * RUN_LINES;
+                if(!(block = realloc(block, maxBlock * sizeof(char*)))) {
+                    DIE("realloc() failed");
+                }
+            }
+            REMOVEQ(q, &block[m++]);
+            n--;
+            if(m == 2) {
+                descending = compareLines(block[0], block[1]) > 0;
+            }
+            if(n == 0 || !headQ(q, &line)) {
+                break;
+            }
+            if(m >= 2 && (compareLines(block[m-1], line) > 0) != descending) {
+                break;
+            }
+        }
+
+        if(descending) {
+            for(long i = 0, j = m - 1; i < j; i++, j--) {
+                char *tmp = block[i];
+                block[i] = block[j];
+                block[j] = tmp;
+            }
+        }
+        for(; m < RUN_LINES && n > 0; m++, n--) {
+            REMOVEQ(q, &line);
+            insertLine(block, m, line);
+        }
+
+        if(k == maxRuns) {
+            maxRuns = maxRuns ? 2 * maxRuns : 64;
+            if(!(runs = realloc(runs, maxRuns * sizeof(Queue)))) {
+                DIE("realloc() failed");
+            }
+        }
+        CREATEQ(&runs[k]);
+        ADDMANYQ(&runs[k], block, m);
+        k++;
+    }
+    free(block);
+
+    // too many runs for one tree: merge consecutive groups of them first
+    while(k > MAX_WAYS) {
+        long j = 0;
+        for(long r = 0; r < k; r += MAX_WAYS) {
+            Queue merged;
+            CREATEQ(&merged);
+            mergeQueues(runs + r, (k - r < MAX_WAYS) ? k - r : MAX_WAYS, &merged);
+            runs[j++] = merged;
+        }
+        k = j;
+    }
+
+    if(k == 1) {
+        DESTROYQ(q);                        // empty now; the run replaces it
+        *q = runs[0];
+    } else if(k > 1) {
+        mergeQueues(runs, k, q);
+    }
+    free(runs);
 }
 
-if(pos > strlen(s2)) {
- s2 = &s2[strlen(s2)]
-} else {
- s2 = s2+pos;
+// Parse a size of the form <number>[K|M|G].  Return -1 if it is invalid.
+
+static long long parseSize(const char *arg) {
+    char *ptr;
+    long long val;
+
+    if(!isdigit(*arg)) {
+        return -1;
+    }
+    val = strtoll(arg, &ptr, 10);
+    if(*ptr == 'K' || *ptr == 'k') {
+        val <<= 10, ptr++;
+    } else if(*ptr == 'M' || *ptr == 'm') {
+        val <<= 20, ptr++;
+    } else if(*ptr == 'G' || *ptr == 'g') {
+        val <<= 30, ptr++;
+    }
+    return *ptr ? -1 : val;
 }
 
-return strncmp(s1, s2, len);
+// Print the lines in *Q and free them.
+
+static void printQueue(Queue *q) {
+    char *line;
+
+    while(!isEmptyQ(q)) {
+        REMOVEQ(q, &line);
+        putLine(line, stdout);
+        freeLine(line);
+    }
 }
 
 int main(int argc, char **argv) {
 
     FILE *fp;
-    Queue Q1, Q2;
-    int times = 2;
-    int res;
-    int q1Count = 0, q2Count = 0;
+    Queue Q;
+    long count = 0;                 // lines in Q
+    long long bytes = 0;            // memory charged to them
+    long long budget = -1;          // -M SIZE, or -1 for no limit
+    Runs runs = NULL;               // sorted runs spilled to temporary files
     int pos = 0;
     int len = INT_MAX;
     int hasKey = 0;
+    int threads = 1;                // -j N
+    bool radix = false;             // -e radix
+    bool zeroCopy = false;          // -z
+    bool pipeline = false;          // -p
+    TopK top = NULL;                // -k K, or NULL to sort everything
+    bool mergeOnly = false;         // -m
+    bool check = false;             // -c
+    FILE **inputs = NULL;           // the files, all keyed by POS and LEN
+    int numInputs = 0;
+    Ingest ingest;
     char *ptr, *ptr1;
-    char *line, *nextLine;
+    char *line;
 
     if(argc < 2) {
-        DIE("usage: Merge16 [-POS[,LEN]] [filename]*");
+        DIE("usage: Merge16 [-POS[,LEN]] [-M SIZE] [-j N] [-e merge|radix] [-z] [-p] [-k K] [-m [-c]] [filename]*");
     }
 
-
-    // create the 2 queues
-    CREATEQ(&Q1);
-    CREATEQ(&Q2);
-
-    Queue *activeQ = &Q1;
+    CREATEQ(&Q);
 
     // arg parsing
     for (++argv; --argc; argv++) {
         if(*argv[0] == '-' && isdigit(argv[0][1]) && !hasKey) {
-            pos = strtol(argv[0], &ptr, 10);            
-            if(strlen(ptr) && *ptr == ',') {            
+            pos = strtol(argv[0]+1, &ptr, 10);
+            if(strlen(ptr) && *ptr == ',') {
                 ptr++;
                 len = strtol(ptr, &ptr1, 10);
                 if(strlen(ptr1)) {
@@ -87,151 +286,135 @@ int main(int argc, char **argv) {
             hasKey = 1;
             continue;
 
-        } else if ((fp = fopen(argv[0], 'r'))) {
+        } else if (strncmp(argv[0], "-M", 2) == 0) {
+            const char *size = argv[0][2] ? argv[0]+2 : (--argc ? *++argv : "");
+            if((budget = parseSize(size)) < 0) {
+                DIE("invalid SIZE");
+            }
+            continue;
 
-            while((line = getLine(fp))) {
-                  removeNewline(line);
+        } else if (strncmp(argv[0], "-j", 2) == 0) {
+            const char *num = argv[0][2] ? argv[0]+2 : (--argc ? *++argv : "");
+            threads = strtol(num, &ptr, 10);
+            if(!isdigit(*num) || *ptr || threads < 1) {
+                DIE("invalid N");
+            }
+            continue;
 
-                  if((nextLine = getLine(fp))) {
-                    removeNewline(nextLine);
-                    res = Strcmp(line, nextLine, pos, len);
+        } else if (strncmp(argv[0], "-e", 2) == 0) {
+            const char *engine = argv[0][2] ? argv[0]+2 : (--argc ? *++argv : "");
+            if(strcmp(engine, "radix") == 0) {
+                radix = true;
+            } else if (strcmp(engine, "merge") == 0) {
+                radix = false;
+            } else {
+                DIE("invalid ENGINE");
+            }
+            continue;
 
-			  if(res <= 0) {
-			    ADDQ(activeQ, line);
-			    ADDQ(activeQ, nextLine);
-			  } else {
-			    ADDQ(activeQ, nextLine);
-			    ADDQ(activeQ, line);
-			  } 
+        } else if (strcmp(argv[0], "-z") == 0) {
+            zeroCopy = true;
+            setvbuf(stdout, NULL, _IOFBF, OUT_BUFFER);
+            continue;
 
-                  } else {
-                    ADDQ(activeQ, line);
+        } else if (strncmp(argv[0], "-k", 2) == 0) {
+            const char *num = argv[0][2] ? argv[0]+2 : (--argc ? *++argv : "");
+            long k = strtol(num, &ptr, 10);
+            if(!isdigit(*num) || *ptr) {
+                DIE("invalid K");
+            }
+            top = createTopK(k);
+            continue;
 
-                    if(q == &Q1) q1Count++;
-                    else q2Count++;
+        } else if (strcmp(argv[0], "-p") == 0) {
+            pipeline = true;
+            continue;
 
-		    break;
-                  }
+        } else if (strcmp(argv[0], "-m") == 0) {
+            mergeOnly = true;
+            continue;
 
-                 
-                  if(activeQ == &Q1) {
-		    q1Count += 2;
-                    activeQ = &Q2;
-                  } else if (activeQ == &Q2) {
-		    q2Count += 2;
-		    activeQ = &Q1;
-                  }
-            }
+        } else if (strcmp(argv[0], "-c") == 0) {
+            check = true;
+            continue;
 
-            fclose(fp);
+        } else if ((fp = fopen(argv[0], "r"))) {
+            if(!(inputs = realloc(inputs, (numInputs + 1) * sizeof(FILE*)))) {
+                DIE("realloc() failed");
+            }
+            inputs[numInputs++] = fp;       // keyed once every option is known
             continue;
         } else {
             DIE("invalid filename");
         }
-        break;
-    }  
-
-
-    int count = q1Count > q2Count ? q1Count : q2Count;
-    int bSize = 2;
-    int *activeQ = &Q1;
-    char *s1, *s2, *next;
-    int bSize1, bSize2;
-
-    while(count > bSize) {
-        // Merge process right here
-        for(int b=0; b<(count+1)/bSize; b++) {
-            for(int p = 0; p < bSize*2 ; p++) {
-		bSize1 = bSize2 = bSize;
-
-		HEADQ(&Q1, &s1);
-		HEADQ(&Q2, &s2);
-
-		if(s1 && s2 && bSize1 && Strcmp(s1, s2, pos, len) <= 0) {
-		 REMOVEQ(&Q1, s1);
-		 ADDQ(activeQ, s1);
-
-		 q1Count--;
-		 activeQ == &Q1 ? q1Count++ : q2Count++;
-		 bSize1--;
- 		} else if(s1 && s2 && bSize2 && Strcmp(s1,s2,pos,len) > 0){
-		 REMOVEQ(&Q2, s2);
-		 ADDQ(activeQ, s2);
-
-	         q2Count--;
-		 activeQ == &Q1 ? q1Count++ : q2Count++;
-		 bSize2--;
-		} else if (s1 && bSize1) {
-		 REMOVEQ(&Q1, s1);
-  		 ADDQ(activeQ, s1);
-
-		 q1Count--;
-		 activeQ == &Q1 ? q1Count++ : q2Count++;
-		 bSize1--;
-		} else if (s2 && bSize2) {
-		 REMOVEQ(&Q2, s2);
-		 ADDQ(activeQ, s2);
-
-		 q2Count--;
-		 activeQ == &Q1 ? q1Count++ : q2Count++;
-		 bSize2--;
-		} else {
-		  break;
-		}
-			
-		// iterate over the length of the combined bucke
-		// have to make sure you don't add more than bSize elements
-		// from one q (even if they are < elements in the other queue
-            }
+    }
+    if(pipeline && zeroCopy) {
+        DIE("-p cannot be used with -z");
+    }
+    if(check && !mergeOnly) {
+        DIE("-c can only be used with -m");
+    }
+    if(mergeOnly) {
+        if(top) {
+            DIE("-k cannot be used with -m");
+        }
+        if(numInputs > 0) {
+            mergeFiles(inputs, numInputs, stdout, pos, len, check);
+        }
+        free(inputs);
+        DESTROYQ(&Q);
+        return EXIT_SUCCESS;
+    }
 
-            // Switch queues
-            // // maybe update the lengths of each q based on how many remove
-            // and how many added
-            if(activeQ == &Q1) {
-                activeQ = &Q2;
-            } else if (activeQ == &Q2) {
-                activeQ = &Q1;
+    ingest = createIngest(inputs, numInputs, pos, len, pipeline, zeroCopy);
+    while((line = nextIngest(ingest))) {
+        if(top) {
+            bool mapped = LINE(line)->mapped;
+            offerTopK(top, line);
+            if(mapped) {
+                releaseLines();             // any line kept was copied
             }
-		// keep track of number of entries read from each queue,
-		// dont remove more when numremoved = bSize
+            continue;
         }
-	count = q1Count > q2Count ? q1Count : q2Count;
-        bSize *= 2;
-    }
-
-
-    // Print queue
-    // output the queue
-    while(!ISEMPTYQ(&Q1) || !ISEMPTY(&Q2)) {
-        REMOVEQ(&Q1, &line);
-	REMOVEQ(&Q2, &nextLine);
-	
-	if(line && nextLine && Strcmp(line, nextLine, pos, len) <= 0) { 
-        printf("%s\n", line);
-        printf("%s\n", nextLine);
-	} else if (line && nextLine && Strcmp(line, nextLine, pos, len > 0) {
-        printf("%s\n", nextLine);
-        printf("%s\n", line);
-	} else if (line) {
-        printf("%s\n", line);
-	}  else if (nextLine) {
-        printf("%s\n", nextLine);
-	} else {
-	 break;
-	}
-
-        if(line) free(line);
-	if(nextLine) free(nextLine);
-    }
-
-    // destroy the 2 queues
-    DESTROYQ(&Q1);
-    DESTROYQ(&Q2);
-
-    return EXIT_SUCCESS;
-}
-
+        ADDQ(&Q, line);
+        count++;
+        bytes += sizeof(Line) + (LINE(line)->mapped ? sizeof(Slice) : strlen(LINE(line)->text) + 1)
+                 + LINE_OVERHEAD
+                 + (threads > 1 || radix ? 2 * sizeof(char*) : 0)   // sorting arrays
+                 + (radix ? 2 * sizeof(uint64_t) + 1 : 0);           // radix keys
+
+        if(budget >= 0 && bytes > budget) {
+            // out of room: sort what we have and write it out as a run
+            sortQueueParallel(&Q, count, threads, radix);
+            if(!runs) {
+                runs = createRuns(pos, len);
+            }
+            addRun(runs, spillRun(&Q));
+            releaseLines();
+            count = bytes = 0;
+        }
+    }
+    destroyIngest(ingest);
 
+    sortQueueParallel(&Q, count, threads, radix);
 
+    if(top) {
+        printTopK(top, stdout);
+    } else if(!runs) {
+        printQueue(&Q);
+    } else {
+        if(count > 0) {
+            addRun(runs, spillRun(&Q));
+        }
+        finishRuns(runs, stdout);
+    }
+    if(fflush(stdout) != 0) {
+        DIE("write failed");
+    }
 
+    // destroy the queue
+    DESTROYQ(&Q);
+    unmapFiles();
 
+    return EXIT_SUCCESS;
+}
@@ -9,13 +9,93 @@
  #ifndef MERGE16_H
  #define MERGE16_H
 
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+
 // Print message to stderr and exit.
 #define DIE(msg) exit (fprintf (stderr, "%s\n", msg));
 
+#define ADDQ(Q,S) if(!addQ(Q,S)) DIE("addQ() failed");
+#define CREATEQ(Q) if(!createQ(Q)) DIE("createQ() failed");
+#define HEADQ(Q,S) if(!headQ(Q,S)) DIE("headQ() failed");
+#define REMOVEQ(Q,S) if(!removeQ(Q,S)) DIE("removeQ() failed");
+#define DESTROYQ(Q) if(!destroyQ(Q)) DIE("destroyQ() failed");
+#define APPENDQ(D,S) if(!appendQ(D,S)) DIE("appendQ() failed");
+#define ADDMANYQ(Q,S,N) if(!addManyQ(Q,S,N)) DIE("addManyQ() failed");
+#define REMOVEMANYQ(Q,S,N) if(!removeManyQ(Q,S,N)) DIE("removeManyQ() failed");
+
+// A line and its key.  A line read from a stream is copied into one block
+// after its Line; a line of a mapped file (-z) stays where it is in the
+// mapping, a Slice locating it takes the place of the copy, and its Line
+// comes from an arena.  The queues hold the address of the Line, as a char*.
+typedef struct line {
+    uint64_t prefix;        // first 8 bytes of the key, big-endian, zero-padded
+    unsigned keyOff : 31;   // where the key starts in the line (at most POS)
+    unsigned mapped : 1;    // the line is in a mapped file
+    uint32_t keyLen;        // length of the key
+    char text[];            // the line, null-terminated; or if mapped, a Slice
+} Line;
+
+// Where a mapped line is.
+typedef struct slice {
+    const char *text;       // not null-terminated
+    size_t len;
+} Slice;
+
+// The Line whose address S is.
+#define LINE(s) ((Line*)(s))
+
+// The text of LINE (not null-terminated if it is mapped).
+#define TEXT(line) ((line)->mapped ? ((const Slice*)(line)->text)->text : (line)->text)
+
  // function prototypes
- void frontBackSplit(Queue *q, Queue *front, Queue *back);
- Queue* merge(Queue *q1, Queue *q2, int pos, int len);
- void mergeSort(Queue *q, int pos, int len);
+ void sortQueue(Queue *q, long n);
+
+ /* Line.c */
+ char *newLine(const char *s, size_t n, int pos, int len);
+ void freeLine(char *s);
+ char *copyLine(const char *s);
+ char *readLine(FILE *fp, char **buf, size_t *cap, int pos, int len);
+ bool mapFile(FILE *fp, const char **start, const char **end);
+ char *mapLine(const char **p, const char *end, int pos, int len);
+ void releaseLines(void);
+ void unmapFiles(void);
+ void putLine(const char *s, FILE *fp);
+ int compareLines(const char *s1, const char *s2);
+
+ /* LoserTree.c */
+ typedef struct loserTree *LoserTree;
+ LoserTree createTree(char **heads, int k);
+ int winnerTree(LoserTree t, char **s);
+ void replaceTree(LoserTree t, char *s);
+ void destroyTree(LoserTree t);
+
+ /* ParallelSort.c */
+ void sortQueueParallel(Queue *q, long n, int threads, bool radix);
+
+ /* Radix.c */
+ void radixSort(char **a, char **tmp, long n);
+
+ /* TopK.c */
+ typedef struct topK *TopK;
+ TopK createTopK(long k);
+ void offerTopK(TopK t, char *line);
+ void printTopK(TopK t, FILE *fp);
+
+ /* Ingest.c */
+ typedef struct ingest *Ingest;
+ Ingest createIngest(FILE **fp, int n, int pos, int len, bool pipeline, bool zeroCopy);
+ char *nextIngest(Ingest g);
+ void destroyIngest(Ingest g);
+
+ /* Runs.c */
+ typedef struct runs *Runs;
+ FILE *spillRun(Queue *q);
+ void mergeFiles(FILE *in[], int k, FILE *out, int pos, int len, bool check);
+ Runs createRuns(int pos, int len);
+ void addRun(Runs r, FILE *fp);
+ void finishRuns(Runs r, FILE *out);
 
  #endif
  /* end MERGE16_H */
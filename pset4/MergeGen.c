@@ -0,0 +1,88 @@
+/******************************************************************************
+ * MergeGen.c
+ * Input generator for benchmarking Merge16
+ *
+ *   MergeGen random N MIN MAX SEED   N lines of MIN to MAX random letters
+ *   MergeGen few N MIN MAX SEED      N lines, each one of 16 bodies of MIN to
+ *                                    MAX letters followed by its line number
+ *
+ * Every key taken from within the body of a "few" line is one of 16, so
+ * lines with equal keys abound and a stable sort is told from an unstable
+ * one.  Sorted and reverse-sorted inputs are made from these by sorting them
+ * on the key being benchmarked.  The letters are printable and lines have no
+ * carriage returns, so sort(1) and Merge16 see the same lines.
+ *
+ * Harrison Miller
+ ******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+// Print message to stderr and exit.
+#define DIE(msg) exit (fprintf (stderr, "%s\n", msg));
+
+#define BODIES 16               // distinct bodies of "few" lines
+
+static uint64_t state;          // xorshift64* state, so runs are repeatable
+
+static unsigned randomInt(unsigned n) {
+    state ^= state >> 12;
+    state ^= state << 25;
+    state ^= state >> 27;
+    return (state * 0x2545f4914f6cdd1dULL >> 32) % n;
+}
+
+// Store a random string of MIN to MAX letters in S (which has room for MAX
+// and a null).
+
+static void randomWord(char *s, int min, int max) {
+    int n = min + randomInt(max - min + 1);
+
+    for(int i = 0; i < n; i++) {
+        s[i] = 'a' + randomInt(26);
+    }
+    s[n] = '\0';
+}
+
+int main(int argc, char **argv) {
+    long n;
+    int min, max;
+    char *line;
+    char *body;                 // the bodies, MAX+1 bytes apart
+
+    if(argc != 6) {
+        DIE("usage: MergeGen random|few N MIN MAX SEED");
+    }
+    n = atol(argv[2]);
+    min = atoi(argv[3]);
+    max = atoi(argv[4]);
+    state = strtoull(argv[5], NULL, 10) * 2654435761u + 1;
+    if(n < 0 || min < 0 || max < min) {
+        DIE("invalid N, MIN or MAX");
+    }
+    if(!(line = malloc(max + 1)) || !(body = malloc(BODIES * (max + 1)))) {
+        DIE("malloc() failed");
+    }
+
+    if(strcmp(argv[1], "random") == 0) {
+        for(long i = 0; i < n; i++) {
+            randomWord(line, min, max);
+            puts(line);
+        }
+    } else if (strcmp(argv[1], "few") == 0) {
+        for(int b = 0; b < BODIES; b++) {
+            randomWord(body + b * (max + 1), min, max);
+        }
+        for(long i = 0; i < n; i++) {
+            printf("%s %ld\n", body + randomInt(BODIES) * (max + 1), i);
+        }
+    } else {
+        DIE("invalid KIND");
+    }
+
+    free(line);
+    free(body);
+    return EXIT_SUCCESS;
+}
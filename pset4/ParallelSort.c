@@ -0,0 +1,238 @@
+/******************************************************************************
+ * ParallelSort.c
+ * Sorting a queue of lines with several threads
+ *
+ * The lines are taken out of the queue into an array, which is cut into one
+ * equal chunk per thread.  Each thread sorts its chunk with a bottom-up merge
+ * sort (or radixSort(), with -e radix), and then the chunks are merged in pairs, round after round, until one
+ * is left.
+ *
+ * So that the threads share every round evenly (even the last, which is one
+ * merge), each round's output is cut into equal slices, one per thread, and
+ * each thread finds where its slice starts in the two runs it comes from by
+ * binary search on the merge path: the Jth output line of a merge of A and B
+ * is made of the first I lines of A and J-I of B, for the I at which the path
+ * crosses that diagonal.  The threads then merge their slices independently.
+ *
+ * Every merge takes equal keys from the earlier run first, so the sort is as
+ * stable as sortQueue().  With one thread this is just the chunk sort, which
+ * is how the radix engine sorts even without -j.
+ *
+ * HWK #4
+ * Merging Queues
+ *
+ * Harrison Miller
+ ******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "/c/cs223/Hwk4/Queue.h"
+#include "QueueExt.h"
+#include "Merge16.h"
+
+#define RUN_LINES 32            // lines in the blocks each chunk starts with
+#define MIN_CHUNK 4096          // fewest lines worth giving a thread
+
+// What one thread does in one phase.
+typedef struct job {
+    char **src, **dst;          // lines are merged from src into dst
+    long *bound;                // run r is src[bound[r]..bound[r+1]-1]
+    int numRuns;
+    long n;                     // lines in all
+    int id, threads;            // this thread's slice, and how many there are
+    void (*sort)(char **a, char **tmp, long n);  // how to sort a chunk
+} Job;
+
+// Merge the sorted lines A[0..M-1] and B[0..N-1] into OUT, taking lines with
+// equal keys from A first.
+
+static void mergeLines(char **a, long m, char **b, long n, char **out) {
+    long i = 0, j = 0;
+
+    while(i < m && j < n) {
+        if(compareLines(b[j], a[i]) < 0) {
+            *out++ = b[j++];
+        } else {
+            *out++ = a[i++];
+        }
+    }
+    memcpy(out, a + i, (m - i) * sizeof(char*));
+    memcpy(out + (m - i), b + j, (n - j) * sizeof(char*));
+}
+
+// Return how many of the first D lines of the stable merge of A[0..M-1] and
+// B[0..N-1] come from A.  That is the least I for which A[I] does not come
+// before B[D-I-1], searched for between the diagonal's ends.
+
+static long coRank(long d, char **a, long m, char **b, long n) {
+    long lo = d > n ? d - n : 0;
+    long hi = d < m ? d : m;
+
+    while(lo < hi) {
+        long i = (lo + hi) / 2;
+        if(compareLines(b[d-i-1], a[i]) >= 0) {
+            lo = i + 1;                     // A[i] is among the first d
+        } else {
+            hi = i;
+        }
+    }
+    return lo;
+}
+
+// Sort the N lines A[0..N-1] stably, using TMP[0..N-1] for scratch: sort
+// blocks of RUN_LINES by insertion, then merge pairs of them, pass by pass.
+
+static void sortChunk(char **a, char **tmp, long n) {
+    char **src = a, **dst = tmp, **swap;
+
+    for(long lo = 0; lo < n; lo += RUN_LINES) {
+        long hi = (n - lo < RUN_LINES) ? n : lo + RUN_LINES;
+        for(long i = lo + 1; i < hi; i++) {
+            char *line = a[i];
+            long j = i;
+            for(; j > lo && compareLines(a[j-1], line) > 0; j--) {
+                a[j] = a[j-1];
+            }
+            a[j] = line;
+        }
+    }
+
+    for(long width = RUN_LINES; width < n; width *= 2) {
+        for(long lo = 0; lo < n; lo += 2 * width) {
+            long mid = (n - lo < width) ? n : lo + width;
+            long hi = (n - mid < width) ? n : mid + width;
+            if(mid == hi || compareLines(src[mid-1], src[mid]) <= 0) {
+                memcpy(dst + lo, src + lo, (hi - lo) * sizeof(char*));
+            } else {
+                mergeLines(src + lo, mid - lo, src + mid, hi - mid, dst + lo);
+            }
+        }
+        swap = src, src = dst, dst = swap;
+    }
+    if(src != a) {
+        memcpy(a, src, n * sizeof(char*));
+    }
+}
+
+// Sort this thread's chunk of SRC, using DST for scratch.
+
+static void *sortJob(void *arg) {
+    Job *job = arg;
+    long lo = job->bound[job->id], hi = job->bound[job->id + 1];
+
+    job->sort(job->src + lo, job->dst + lo, hi - lo);
+    return NULL;
+}
+
+// Write this thread's slice of one round's output: the lines of DST from
+// N*ID/THREADS up to N*(ID+1)/THREADS, where the round merges runs 0 and 1 of
+// SRC, 2 and 3, and so on (and copies a last odd run as it is).  The slice may
+// take in the ends of several merges.
+
+static void *mergeJob(void *arg) {
+    Job *job = arg;
+    long first = job->n * job->id / job->threads;
+    long last = job->n * (job->id + 1) / job->threads;
+
+    for(int r = 0; r < job->numRuns; r += 2) {
+        long start = job->bound[r];
+        long mid = job->bound[r + 1];
+        long end = job->bound[(r + 2 < job->numRuns) ? r + 2 : job->numRuns];
+        long lo = (first > start) ? first : start;
+        long hi = (last < end) ? last : end;
+        char **a = job->src + start, **b = job->src + mid;
+        long i, j;
+
+        if(lo >= hi) {
+            continue;
+        }
+        i = coRank(lo - start, a, mid - start, b, end - mid);
+        j = coRank(hi - start, a, mid - start, b, end - mid);
+        mergeLines(a + i, j - i, b + (lo - start - i), (hi - start - j) - (lo - start - i),
+                   job->dst + lo);
+    }
+    return NULL;
+}
+
+// Run FN on each of the THREADS jobs JOBS[] at once and wait for them all.
+
+static void runJobs(void *(*fn)(void*), Job jobs[], int threads) {
+    pthread_t *tid = malloc(threads * sizeof(pthread_t));
+
+    if(!tid) {
+        DIE("malloc() failed");
+    }
+    for(int t = 1; t < threads; t++) {
+        if(pthread_create(&tid[t], NULL, fn, &jobs[t]) != 0) {
+            DIE("pthread_create() failed");
+        }
+    }
+    fn(&jobs[0]);                           // this thread does a share too
+    for(int t = 1; t < threads; t++) {
+        pthread_join(tid[t], NULL);
+    }
+    free(tid);
+}
+
+// Sort the N lines in *Q by key with THREADS threads, stably, by merge sort
+// or if RADIX by radixSort().  Too few lines to be worth more than one thread
+// get one, and a merge sort with one thread (or any sort of fewer than two
+// lines) is left to sortQueue().
+
+void sortQueueParallel(Queue *q, long n, int threads, bool radix) {
+    void (*sort)(char **a, char **tmp, long n) = radix ? radixSort : sortChunk;
+    char **lines, **tmp, **swap;
+    long *bound;
+    Job *jobs;
+    int numRuns;
+
+    if(threads > n / MIN_CHUNK) {
+        threads = n / MIN_CHUNK;
+    }
+    if(threads < 1) {
+        threads = 1;
+    }
+    if((threads == 1 && !radix) || n < 2) {
+        sortQueue(q, n);
+        return;
+    }
+
+    if(!(lines = malloc(n * sizeof(char*))) || !(tmp = malloc(n * sizeof(char*)))
+       || !(bound = malloc((threads + 1) * sizeof(long)))
+       || !(jobs = malloc(threads * sizeof(Job)))) {
+        DIE("malloc() failed");
+    }
+    REMOVEMANYQ(q, lines, n);
+
+    // each thread sorts one chunk
+    for(int t = 0; t <= threads; t++) {
+        bound[t] = n * t / threads;
+    }
+    for(int t = 0; t < threads; t++) {
+        jobs[t] = (Job){lines, tmp, bound, threads, n, t, threads, sort};
+    }
+    runJobs(sortJob, jobs, threads);
+
+    // then all of them merge each round's pairs of chunks together
+    for(numRuns = threads; numRuns > 1; numRuns = (numRuns + 1) / 2) {
+        for(int t = 0; t < threads; t++) {
+            jobs[t] = (Job){lines, tmp, bound, numRuns, n, t, threads, sort};
+        }
+        runJobs(mergeJob, jobs, threads);
+
+        for(int r = 0; r <= (numRuns + 1) / 2; r++) {
+            bound[r] = bound[(2 * r < numRuns) ? 2 * r : numRuns];
+        }
+        swap = lines, lines = tmp, tmp = swap;
+    }
+
+    ADDMANYQ(q, lines, n);
+    free(lines);
+    free(tmp);
+    free(bound);
+    free(jobs);
+}
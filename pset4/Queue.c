@@ -2,6 +2,22 @@
  * Queue.c
  * Implementation of Queue ADT
  *
+ * Nodes come from a freelist rather than from malloc() and free() one at a
+ * time.  When the freelist is empty a slab of SLAB_NODES nodes is malloc'd and
+ * added to it; removeQ puts a node back on it, and destroyQ puts back a whole
+ * queue at once by splicing its circular list onto the freelist.  Slabs are
+ * kept for reuse until the program exits.
+ *
+ * The freelist is shared by every queue and is not locked.  Compile with
+ * -DQUEUE_THREAD_LOCAL to give each thread its own freelist and slabs instead,
+ * so threads can use separate queues at once.
+ *
+ * A Queue points to a header node, taken from the same freelist, which holds
+ * the number of strings and a pointer to the tail of their circular list; so
+ * sizeQ() is O(1) and costs one node per queue rather than a field in every
+ * node.  appendQ() splices two circular lists in O(1) by swapping their
+ * tails' next pointers.
+ *
  * HWK #4
  * Merging Queues
  *
@@ -10,16 +26,76 @@
 
 #include <stdlib.h> 
 #include "/c/cs223/Hwk4/Queue.h"
+#include "QueueExt.h"
 
-typedef struct node {
-   char *data;
-   struct node *next;
+// A Queue points to its header node, whose next is the tail of the strings'
+// nodes (NULL if there are none).  Their list is circular, so the tail's next
+// is the head.
+typedef struct queue {
+   union {
+       char *data;              // the string (a string's node)
+       size_t size;             // number of strings (the header)
+   } u;
+   struct queue *next;          // the next node, or the tail (the header)
  } Node;
 
+#define SLAB_NODES 1024         // nodes malloc'd at a time
+
+#ifdef QUEUE_THREAD_LOCAL
+#define LOCAL __thread
+#else
+#define LOCAL
+#endif
+
+static LOCAL Node *freeList;    // nodes not in any queue, linked by next
+
+// Return a node from the freelist, refilling it with a new slab if it is
+// empty, or NULL if malloc() fails.
+
+static Node *allocNode (void) {
+    Node *node = freeList;
+
+    if(!node) {
+        Node *slab = malloc(SLAB_NODES * sizeof(Node));
+        if(!slab) {
+            return NULL;
+        }
+        for(int i = 0; i < SLAB_NODES - 1; i++) {
+            slab[i].next = &slab[i+1];
+        }
+        slab[SLAB_NODES-1].next = NULL;
+        node = slab;
+    }
+
+    freeList = node->next;
+    return node;
+}
+
+// Put a node back on the freelist.
+
+static void freeNode (Node *node) {
+    node->next = freeList;
+    freeList = node;
+}
+
+// Put the nodes from HEAD to LAST (following next) back on the freelist.
+
+static void freeNodes (Node *head, Node *last) {
+    last->next = freeList;
+    freeList = head;
+}
+
  // Set *Q to a new object of type Queue.  Return status.
 
-int createQ (Queue *q) {
-    *q = NULL;
+bool createQ (Queue *q) {
+    Node *header = allocNode();
+
+    if(!header) {
+        return false;
+    }
+    header->u.size = 0;
+    header->next = NULL;
+    *q = header;
     return true;
 }
 
@@ -27,27 +103,28 @@ int createQ (Queue *q) {
 // Add the string pointer S to the tail of Queue *Q; the string itself is not
 // copied.  *Q may change as a result.  Return status.
 
-int addQ (Queue *q, char *s) {
-    Node *new;
+bool addQ (Queue *q, char *s) {
+    Node *new, *tail = (*q)->next;
 
     if(!s) {
         return false;
     }
 
-    if(!(new = malloc(sizeof(Node)))) {
+    if(!(new = allocNode())) {
         return false;
     }
 
-    new->data = s;
+    new->u.data = s;
 
-    if(isEmptyQ(q)) {
-      new->next = new;
+    if(!tail) {
+        new->next = new;
     } else {
-	    new->next = (*q)->next;
-	    (*q)->next = new;                                      
-     }                                              
-    *q = new;
-    
+        new->next = tail->next;
+        tail->next = new;
+    }
+    (*q)->next = new;
+    (*q)->u.size++;
+
     return true;
 }
 
@@ -55,19 +132,19 @@ int addQ (Queue *q, char *s) {
 // Return TRUE if the Queue *Q is empty, FALSE otherwise.  *Q may change as a
 // result.
 
-int isEmptyQ (Queue *q) {
-    return !*q;     
+bool isEmptyQ (Queue *q) {
+    return !*q || !(*q)->next;
 }
 
 // Copy the string pointer at the head of Queue *Q to *S, but do not remove it
 // from *Q.  *Q may change as a result.  Return status.  (If *Q is empty, then
 // returns FALSE and leaves *S unchanged.)
 
-int headQ (Queue *q, char **s) {
+bool headQ (Queue *q, char **s) {
     if(isEmptyQ(q)) {
         return false;
     }
-    *s = (*q)->next->data;
+    *s = (*q)->next->next->u.data;
     return true;
 }
 
@@ -76,26 +153,26 @@ int headQ (Queue *q, char **s) {
 // in *S.  *Q may change as a result.  Return status.  (If *Q is empty, then
 // returns FALSE and leaves *S unchanged.)
 
-int removeQ (Queue *q, char **s) {
-    Node *head = (*q)->next;
-    int isLast = 0;
-
-    if(head = *q) {
-	isLast = 1;
-    }
+bool removeQ (Queue *q, char **s) {
+    Node *tail, *head;
 
     if(isEmptyQ(q)) {
         return false;
     }
- 
+
+    tail = (*q)->next;
+    head = tail->next;
     if(s) {
-        *s = head->data;                            // store head string ptr
+        *s = head->u.data;                          // store head string ptr
     }
 
-    (*q)->next = head->next;
-    free(head);                     
-
-    if(isLast) *q = NULL;
+    if(head == tail) {
+        (*q)->next = NULL;                          // that was the last
+    } else {
+        tail->next = head->next;
+    }
+    (*q)->u.size--;
+    freeNode(head);
 
     return true;
 }
@@ -103,16 +180,132 @@ int removeQ (Queue *q, char **s) {
 // Destroy the Queue *Q by freeing any storage it uses (but not that to which
 // the string pointers point).  Set *Q to NULL.  Return status.
 
-int destroyQ (Queue *q) {
-    while(!isEmpty(q)) {
-        if(!removeQ(q, NULL)) {
-            return false;
+bool destroyQ (Queue *q) {
+    if(*q) {
+        if((*q)->next) {
+            // the tail's next is the head, so the list from the head to the
+            // tail goes onto the freelist in one step
+            Node *tail = (*q)->next;
+            freeNodes(tail->next, tail);
         }
+        freeNode(*q);
     }
 
     *q = NULL;
     return true;
 }
 
+// Move every string pointer in Queue *SRC to the tail of Queue *DST, in
+// order, leaving *SRC empty.  *DST and *SRC may change as a result.  Return
+// status.  (If they are the same queue, returns FALSE and leaves it
+// unchanged.)
 
+bool appendQ (Queue *dst, Queue *src) {
+    Node *tail;
+
+    if(dst == src || (*dst == *src && !isEmptyQ(src))) {
+        return false;
+    }
+    if(isEmptyQ(src)) {
+        return true;
+    }
 
+    tail = (*src)->next;
+    if(!isEmptyQ(dst)) {
+        // dst's tail now leads to src's head, and src's tail to dst's head
+        Node *head = (*dst)->next->next;
+        (*dst)->next->next = tail->next;
+        tail->next = head;
+    }
+    (*dst)->next = tail;
+    (*dst)->u.size += (*src)->u.size;
+    (*src)->next = NULL;
+    (*src)->u.size = 0;
+    return true;
+}
+
+// Add the N string pointers S[0..N-1] to the tail of Queue *Q, in order.  *Q
+// may change as a result.  Return status.  (If any is NULL, or there is no
+// memory, returns FALSE and leaves *Q unchanged.)
+
+bool addManyQ (Queue *q, char **s, size_t n) {
+    Node *head = NULL, *tail = NULL;
+
+    if(n == 0) {
+        return true;
+    }
+    for(size_t i = 0; i < n; i++) {
+        if(!s[i]) {
+            return false;
+        }
+    }
+
+    // link the new nodes into a list of their own first, so that running out
+    // of memory part way leaves *Q as it was
+    for(size_t i = 0; i < n; i++) {
+        Node *new = allocNode();
+        if(!new) {
+            if(head) {
+                freeNodes(head, tail);
+            }
+            return false;
+        }
+        new->u.data = s[i];
+        if(tail) {
+            tail->next = new;
+        } else {
+            head = new;
+        }
+        tail = new;
+    }
+
+    // then splice them in after the tail
+    if(isEmptyQ(q)) {
+        tail->next = head;
+    } else {
+        tail->next = (*q)->next->next;
+        (*q)->next->next = head;
+    }
+    (*q)->next = tail;
+    (*q)->u.size += n;
+    return true;
+}
+
+// Remove N string pointers from the head of Queue *Q and store them in
+// S[0..N-1], in order.  *Q may change as a result.  Return status.  (If *Q
+// has fewer than N, returns FALSE and leaves *Q unchanged.)
+
+bool removeManyQ (Queue *q, char **s, size_t n) {
+    Node *tail, *head, *last;
+
+    if(sizeQ(q) < n) {
+        return false;
+    }
+    if(n == 0) {
+        return true;
+    }
+
+    // copy out the first n, then put them on the freelist in one step
+    tail = (*q)->next;
+    head = last = tail->next;
+    *s++ = last->u.data;
+    for(size_t i = 1; i < n; i++) {
+        last = last->next;
+        *s++ = last->u.data;
+    }
+
+    if(last == tail) {
+        (*q)->next = NULL;
+    } else {
+        tail->next = last->next;
+    }
+    (*q)->u.size -= n;
+    freeNodes(head, last);
+    return true;
+}
+
+// Return the number of string pointers in Queue *Q.
+
+size_t sizeQ (Queue *q) {
+    return *q ? (*q)->u.size : 0;
+}
@@ -0,0 +1,139 @@
+/******************************************************************************
+ * QueueExt.c
+ * The operations of QueueExt.h using the Queue ADT alone
+ *
+ * For linking with a Queue implementation that has only the operations of
+ * Queue.h, such as the course's Queue.o (see Merge16H in the Makefile).  Each
+ * moves one string at a time with addQ and removeQ, so none is O(1); Queue.c
+ * and RingQueue.c have faster versions of their own and must not be linked
+ * with this file.
+ *
+ * HWK #4
+ * Merging Queues
+ *
+ * Harrison Miller
+ ******************************************************************************/
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include "/c/cs223/Hwk4/Queue.h"
+#include "QueueExt.h"
+
+// Move every string pointer in Queue *SRC to the tail of Queue *DST, in
+// order, leaving *SRC empty.  *DST and *SRC may change as a result.  Return
+// status.  (If they are the same queue, returns FALSE and leaves it
+// unchanged.)
+
+bool appendQ (Queue *dst, Queue *src) {
+    char *s;
+
+    if(dst == src || (*dst == *src && !isEmptyQ(src))) {
+        return false;
+    }
+    while(headQ(src, &s)) {
+        if(!addQ(dst, s)) {
+            return false;
+        }
+        removeQ(src, &s);
+    }
+    return true;
+}
+
+// Add the N string pointers S[0..N-1] to the tail of Queue *Q, in order.  *Q
+// may change as a result.  Return status.  (If any is NULL, or there is no
+// memory, returns FALSE and leaves *Q unchanged.)
+
+bool addManyQ (Queue *q, char **s, size_t n) {
+    Queue batch;
+
+    if(!createQ(&batch)) {
+        return false;
+    }
+    for(size_t i = 0; i < n; i++) {
+        if(!addQ(&batch, s[i])) {
+            destroyQ(&batch);
+            return false;
+        }
+    }
+    if(!appendQ(q, &batch)) {
+        destroyQ(&batch);
+        return false;
+    }
+    return destroyQ(&batch);
+}
+
+// Remove N string pointers from the head of Queue *Q and store them in
+// S[0..N-1], in order.  *Q may change as a result.  Return status.  (If *Q
+// has fewer than N, returns FALSE and leaves *Q unchanged.)
+
+bool removeManyQ (Queue *q, char **s, size_t n) {
+    size_t size = sizeQ(q);
+
+    if(size == SIZE_MAX || size < n) {
+        return false;
+    }
+    for(size_t i = 0; i < n; i++) {
+        removeQ(q, &s[i]);
+    }
+    return true;
+}
+
+// Return the number of string pointers in Queue *Q.  The ADT has no way to
+// look past the head, so the strings are moved to another queue, which then
+// takes the place of *Q.  (If there is no memory to count them, returns
+// SIZE_MAX.  *Q is then unchanged if there is room on it for two more
+// strings than it held; if not, the strings REST could not give back are
+// lost, and *Q may be out of order and hold an empty string as the mark.)
+
+size_t sizeQ (Queue *q) {
+    static char mark;           // marks a place in *Q; never a caller's string
+    Queue rest;
+    size_t n = 0;
+    char *s;
+
+    if(!createQ(&rest)) {
+        return SIZE_MAX;
+    }
+
+    // each string goes on REST before it comes off *Q, so a failed addQ()
+    // loses nothing
+    while(headQ(q, &s) && addQ(&rest, s)) {
+        removeQ(q, &s);
+        n++;
+    }
+
+    if(!isEmptyQ(q)) {
+        // out of memory: REST has the first N strings and *Q the others, so
+        // try once more to move those after them, the same way
+        while(headQ(q, &s) && addQ(&rest, s)) {
+            removeQ(q, &s);
+            n++;
+        }
+    }
+
+    if(!isEmptyQ(q)) {
+        // still out of memory: put REST's strings back in front of the others
+        // instead.  *Q takes strings only at its tail, so mark the end of the
+        // others, add REST's strings after the mark, and rotate the others
+        // round behind them, again adding each string before removing it.
+        // That needs room on *Q for two strings more than it first held.
+        bool marked = addQ(q, &mark);
+
+        while(headQ(&rest, &s) && addQ(q, s)) {
+            removeQ(&rest, &s);
+        }
+        while(marked && headQ(q, &s) && s != &mark && addQ(q, s)) {
+            removeQ(q, &s);
+        }
+        if(marked && headQ(q, &s) && s == &mark) {
+            removeQ(q, &s);
+        }
+        destroyQ(&rest);
+        return SIZE_MAX;
+    }
+
+    destroyQ(q);
+    *q = rest;
+    return n;
+}
@@ -0,0 +1,40 @@
+/******************************************************************************
+ * QueueExt.h
+ * Operations on whole queues and batches of strings, beyond the Queue ADT
+ *
+ * Queue.c and RingQueue.c implement these directly; QueueExt.c implements
+ * them with the Queue ADT alone, for linking with a Queue.o that lacks them.
+ *
+ * Harrison Miller
+ ******************************************************************************/
+
+#ifndef QUEUEEXT_H
+#define QUEUEEXT_H
+
+#include <stddef.h>
+
+// (Queue.h must be included first.)
+
+// Move every string pointer in Queue *SRC to the tail of Queue *DST, in
+// order, leaving *SRC empty.  *DST and *SRC may change as a result.  Return
+// status.  (If they are the same queue, returns FALSE and leaves it
+// unchanged.)
+bool appendQ (Queue *dst, Queue *src);
+
+// Add the N string pointers S[0..N-1] to the tail of Queue *Q, in order.  *Q
+// may change as a result.  Return status.  (If any is NULL, or there is no
+// memory, returns FALSE and leaves *Q unchanged.)
+bool addManyQ (Queue *q, char **s, size_t n);
+
+// Remove N string pointers from the head of Queue *Q and store them in
+// S[0..N-1], in order.  *Q may change as a result.  Return status.  (If *Q
+// has fewer than N, returns FALSE and leaves *Q unchanged.)
+bool removeManyQ (Queue *q, char **s, size_t n);
+
+// Return the number of string pointers in Queue *Q.  O(1) in Queue.c and
+// RingQueue.c; QueueExt.c must move every string to count them, and returns
+// SIZE_MAX if there is no memory to do so (see there for what becomes of *Q).
+size_t sizeQ (Queue *q);
+
+#endif
+/* end QUEUEEXT_H */
@@ -0,0 +1,216 @@
+/******************************************************************************
+ * Radix.c
+ * Most-significant-digit radix sort of lines by key
+ *
+ * The lines are distributed into 256 buckets by the first byte of their keys,
+ * then each bucket by the second byte, and so on, so that a byte of a key is
+ * looked at about once however many other keys share the bytes before it; a
+ * comparison sort would compare a shared prefix again in every comparison.
+ * Byte 0 stands for the end of a key (a key never contains a null), so a
+ * key that ends sorts before any longer one and its bucket needs no more
+ * sorting.
+ *
+ * The bytes are not read from the lines but from an array of 8-byte keys
+ * that is permuted along with them: it starts as the lines' prefixes, and
+ * when a bucket gets 8 bytes deep its keys are loaded with the next 8 bytes.
+ * So each level is a sequential scan, and the text of a line is fetched only
+ * once per 8 levels.
+ *
+ * Each distribution is a counting pass, which saves each line's byte, and
+ * then a pass that copies the lines in order into the scratch array and back,
+ * so lines with equal keys keep their order.  Buckets of fewer than
+ * INSERTION_LINES lines are finished by insertion sort.  When a bucket is to
+ * be loaded, the prefix its lines all share is measured in one pass and
+ * skipped, rather than byte by byte (paths and URLs share long prefixes).  Buckets waiting to be sorted are kept on a
+ * stack rather than by recursion, since shared prefixes can be very long.
+ *
+ * HWK #4
+ * Merging Queues
+ *
+ * Harrison Miller
+ ******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "/c/cs223/Hwk4/Queue.h"
+#include "Merge16.h"
+
+#define INSERTION_LINES 32      // buckets smaller than this are insertion-sorted
+
+// A bucket still to be sorted: N lines from A[LO] on, whose keys agree in
+// their first DEPTH bytes, and whose cached keys hold bytes BASE to BASE+7.
+typedef struct bucket {
+    long lo, n;
+    uint32_t depth, base;
+} Bucket;
+
+// Return bytes D to D+7 of LINE's key, big-endian and zero-padded.
+
+static uint64_t loadKey(const Line *line, uint32_t d) {
+    const char *key = TEXT(line) + line->keyOff;
+    uint64_t bytes = 0;
+
+    for(uint32_t i = d; i < d + 8; i++) {
+        bytes = (bytes << 8) | (i < line->keyLen ? (unsigned char)key[i] : 0);
+    }
+    return bytes;
+}
+
+// Return byte D of a key, or 0 past its end, from BYTES, its bytes BASE to
+// BASE+7.
+
+static inline unsigned keyByte(uint64_t bytes, uint32_t d, uint32_t base) {
+    return (bytes >> (56 - 8 * (d - base))) & 0xff;
+}
+
+// Compare the keys of lines S1 and S2, which agree in their first D bytes,
+// and whose bytes BASE to BASE+7 are K1 and K2.
+
+static int compareFrom(const char *s1, uint64_t k1, const char *s2, uint64_t k2,
+                       uint32_t d, uint32_t base) {
+    const Line *a = LINE(s1), *b = LINE(s2);
+    uint32_t n;
+    int cmp;
+
+    if(k1 != k2) {
+        return k1 < k2 ? -1 : 1;
+    }
+    if(d < base + 8) {
+        d = base + 8;
+    }
+    n = a->keyLen < b->keyLen ? a->keyLen : b->keyLen;
+    if(n > d && (cmp = memcmp(TEXT(a) + a->keyOff + d, TEXT(b) + b->keyOff + d, n - d))) {
+        return cmp;
+    }
+    return (a->keyLen > b->keyLen) - (a->keyLen < b->keyLen);
+}
+
+// Sort the bucket's lines A[] (and their keys KEY[]) by insertion, after any
+// with an equal key.
+
+static void insertionSort(char **a, uint64_t *key, Bucket b) {
+    for(long i = b.lo + 1; i < b.lo + b.n; i++) {
+        char *line = a[i];
+        uint64_t k = key[i];
+        long j = i;
+        for(; j > b.lo && compareFrom(a[j-1], key[j-1], line, k, b.depth, b.base) > 0; j--) {
+            a[j] = a[j-1];
+            key[j] = key[j-1];
+        }
+        a[j] = line;
+        key[j] = k;
+    }
+}
+
+// Return how many bytes past the first D the keys of the N lines A[0..N-1]
+// have in common.
+
+static uint32_t commonPrefix(char **a, long n, uint32_t d) {
+    const Line *first = LINE(a[0]);
+    const char *key = TEXT(first) + first->keyOff;
+    uint32_t common = first->keyLen > d ? first->keyLen - d : 0;
+
+    for(long i = 1; i < n && common > 0; i++) {
+        const Line *line = LINE(a[i]);
+        const char *s = TEXT(line) + line->keyOff;
+        uint32_t m = line->keyLen > d ? line->keyLen - d : 0;
+        uint32_t j = 0;
+
+        if(m < common) {
+            common = m;
+        }
+        while(j < common && s[d + j] == key[d + j]) {
+            j++;
+        }
+        common = j;
+    }
+    return common;
+}
+
+// Sort the N lines A[0..N-1] stably by key, using TMP[0..N-1] for scratch.
+
+void radixSort(char **a, char **tmp, long n) {
+    Bucket *stack;
+    long top = 0, maxStack = 256;
+    long count[256];
+    uint64_t *key, *tmpKey;                 // key[i] caches bytes of a[i]'s key
+    unsigned char *byte;                    // byte[i] is the byte of line i
+
+    if(!(stack = malloc(maxStack * sizeof(Bucket))) || !(byte = malloc(n))
+       || !(key = malloc(n * sizeof(uint64_t))) || !(tmpKey = malloc(n * sizeof(uint64_t)))) {
+        DIE("malloc() failed");
+    }
+    for(long i = 0; i < n; i++) {
+        key[i] = LINE(a[i])->prefix;
+    }
+    stack[top++] = (Bucket){0, n, 0, 0};
+
+    while(top > 0) {
+        Bucket b = stack[--top];
+        char **lines = a + b.lo;
+        uint64_t *keys = key + b.lo;
+        unsigned only;                      // the byte every line has, if any
+        long off;
+
+        if(b.n < INSERTION_LINES) {
+            insertionSort(a, key, b);
+            continue;
+        }
+        if(b.depth >= b.base + 8) {         // skip what they all share and load
+            b.depth += commonPrefix(lines, b.n, b.depth);
+            for(long i = 0; i < b.n; i++) {
+                keys[i] = loadKey(LINE(lines[i]), b.depth);
+            }
+            b.base = b.depth;
+        }
+
+        memset(count, 0, sizeof(count));
+        for(long i = 0; i < b.n; i++) {
+            count[byte[i] = keyByte(keys[i], b.depth, b.base)]++;
+        }
+        only = byte[0];
+        if(count[only] == b.n) {
+            if(only != 0) {                 // all alike so far: look further
+                b.depth++;
+                stack[top++] = b;
+            }
+            continue;
+        }
+
+        // bucket i goes at count[i], before its lines are copied there
+        off = 0;
+        for(int i = 0; i < 256; i++) {
+            long c = count[i];
+            count[i] = off;
+            off += c;
+        }
+        for(long i = 0; i < b.n; i++) {
+            long j = count[byte[i]]++;
+            tmp[j] = lines[i];
+            tmpKey[j] = keys[i];
+        }
+        memcpy(lines, tmp, b.n * sizeof(char*));
+        memcpy(keys, tmpKey, b.n * sizeof(uint64_t));
+
+        // count[i] is now where bucket i ends; keys in bucket 0 have ended
+        if(top + 255 > maxStack) {
+            maxStack *= 2;
+            if(!(stack = realloc(stack, maxStack * sizeof(Bucket)))) {
+                DIE("realloc() failed");
+            }
+        }
+        for(int i = 1; i < 256; i++) {
+            long lo = count[i-1];
+            if(count[i] - lo > 1) {
+                stack[top++] = (Bucket){b.lo + lo, count[i] - lo, b.depth + 1, b.base};
+            }
+        }
+    }
+
+    free(stack);
+    free(byte);
+    free(key);
+    free(tmpKey);
+}
@@ -0,0 +1,263 @@
+/******************************************************************************
+ * RingQueue.c
+ * Array-based implementation of Queue ADT
+ *
+ * The string pointers are kept in a ring buffer whose size is a power of two,
+ * so an index wraps with a mask instead of a division.  The buffer doubles
+ * when it fills and never shrinks, so once a queue has held its largest
+ * number of strings, addQ and removeQ allocate nothing and touch only
+ * sequential memory.  It is a drop-in replacement for Queue.c.
+ *
+ * The batch operations copy whole stretches of the ring with memcpy(), at most
+ * two (one each side of the wrap).  appendQ() copies too, unless *DST is empty,
+ * in which case the two queues just trade rings.
+ *
+ * HWK #4
+ * Merging Queues
+ *
+ * Harrison Miller
+ ******************************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+#include "/c/cs223/Hwk4/Queue.h"
+#include "QueueExt.h"
+
+#define INITIAL_SIZE 16		// slots in a new queue (a power of two)
+
+struct queue {
+    char **slot;		// ring of string pointers
+    size_t mask;		// number of slots - 1
+    size_t head;		// index of the head
+    size_t count;		// number of strings in the queue
+};
+
+// Set *Q to a new object of type Queue.  Return status.
+
+bool createQ (Queue *q) {
+    Queue new;
+
+    if(!(new = malloc(sizeof(*new)))) {
+        return false;
+    }
+    if(!(new->slot = malloc(INITIAL_SIZE * sizeof(char*)))) {
+        free(new);
+        return false;
+    }
+    new->mask = INITIAL_SIZE - 1;
+    new->head = new->count = 0;
+
+    *q = new;
+    return true;
+}
+
+
+// Double the number of slots in Q, moving the strings that had wrapped around
+// to the start of the ring so that they follow the others.  Return status.
+
+static bool grow (Queue q) {
+    size_t size = q->mask + 1;
+    char **slot;
+
+    if(!(slot = realloc(q->slot, 2 * size * sizeof(char*)))) {
+        return false;
+    }
+    if(q->head + q->count > size) {
+        memcpy(slot + size, slot, (q->head + q->count - size) * sizeof(char*));
+    }
+    q->slot = slot;
+    q->mask = 2 * size - 1;
+    return true;
+}
+
+
+// Make room in Q for N more strings, doubling its slots as often as needed.
+// Return status.
+
+static bool reserve (Queue q, size_t n) {
+    while(q->count + n > q->mask + 1) {
+        if(!grow(q)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+
+// Copy the N string pointers S[0..N-1] into the ring of Q after its strings
+// (for which there is room), without counting them.
+
+static void putSlots (Queue q, char **s, size_t n) {
+    size_t tail = (q->head + q->count) & q->mask;
+    size_t first = (n < q->mask + 1 - tail) ? n : q->mask + 1 - tail;
+
+    memcpy(q->slot + tail, s, first * sizeof(char*));
+    memcpy(q->slot, s + first, (n - first) * sizeof(char*));
+}
+
+
+// Copy the first N string pointers in Q (which has that many) to S[0..N-1],
+// without removing them.
+
+static void getSlots (Queue q, char **s, size_t n) {
+    size_t first = (n < q->mask + 1 - q->head) ? n : q->mask + 1 - q->head;
+
+    memcpy(s, q->slot + q->head, first * sizeof(char*));
+    memcpy(s + first, q->slot, (n - first) * sizeof(char*));
+}
+
+
+// Add the string pointer S to the tail of Queue *Q; the string itself is not
+// copied.  *Q may change as a result.  Return status.
+
+bool addQ (Queue *q, char *s) {
+    Queue Q = *q;
+
+    if(!s) {
+        return false;
+    }
+    if(Q->count > Q->mask && !grow(Q)) {
+        return false;
+    }
+
+    Q->slot[(Q->head + Q->count++) & Q->mask] = s;
+    return true;
+}
+
+
+// Return TRUE if the Queue *Q is empty, FALSE otherwise.  *Q may change as a
+// result.
+
+bool isEmptyQ (Queue *q) {
+    return !*q || (*q)->count == 0;
+}
+
+// Copy the string pointer at the head of Queue *Q to *S, but do not remove it
+// from *Q.  *Q may change as a result.  Return status.  (If *Q is empty, then
+// returns FALSE and leaves *S unchanged.)
+
+bool headQ (Queue *q, char **s) {
+    if(isEmptyQ(q)) {
+        return false;
+    }
+    *s = (*q)->slot[(*q)->head];
+    return true;
+}
+
+
+// Remove the string pointer at the head of the Queue *Q and store that value
+// in *S.  *Q may change as a result.  Return status.  (If *Q is empty, then
+// returns FALSE and leaves *S unchanged.)
+
+bool removeQ (Queue *q, char **s) {
+    Queue Q = *q;
+
+    if(isEmptyQ(q)) {
+        return false;
+    }
+
+    if(s) {
+        *s = Q->slot[Q->head];                      // store head string ptr
+    }
+    Q->head = (Q->head + 1) & Q->mask;
+    Q->count--;
+
+    return true;
+}
+
+// Destroy the Queue *Q by freeing any storage it uses (but not that to which
+// the string pointers point).  Set *Q to NULL.  Return status.
+
+bool destroyQ (Queue *q) {
+    if(*q) {
+        free((*q)->slot);
+        free(*q);
+    }
+
+    *q = NULL;
+    return true;
+}
+
+// Move every string pointer in Queue *SRC to the tail of Queue *DST, in
+// order, leaving *SRC empty.  *DST and *SRC may change as a result.  Return
+// status.  (If they are the same queue, returns FALSE and leaves it
+// unchanged.)
+
+bool appendQ (Queue *dst, Queue *src) {
+    Queue D = *dst, S = *src;
+    size_t first;
+
+    if(dst == src || (D == S && !isEmptyQ(src))) {
+        return false;
+    }
+    if(isEmptyQ(src)) {
+        return true;
+    }
+    if(!D || D->count == 0) {                   // trade rings
+        *dst = S;
+        *src = D;
+        if(D) {
+            D->head = 0;
+        }
+        return true;
+    }
+    if(!reserve(D, S->count)) {
+        return false;
+    }
+
+    first = (S->count < S->mask + 1 - S->head) ? S->count : S->mask + 1 - S->head;
+    putSlots(D, S->slot + S->head, first);
+    D->count += first;
+    putSlots(D, S->slot, S->count - first);
+    D->count += S->count - first;
+
+    S->head = S->count = 0;
+    return true;
+}
+
+// Add the N string pointers S[0..N-1] to the tail of Queue *Q, in order.  *Q
+// may change as a result.  Return status.  (If any is NULL, or there is no
+// memory, returns FALSE and leaves *Q unchanged.)
+
+bool addManyQ (Queue *q, char **s, size_t n) {
+    Queue Q = *q;
+
+    for(size_t i = 0; i < n; i++) {
+        if(!s[i]) {
+            return false;
+        }
+    }
+    if(!reserve(Q, n)) {
+        return false;
+    }
+
+    putSlots(Q, s, n);
+    Q->count += n;
+    return true;
+}
+
+// Remove N string pointers from the head of Queue *Q and store them in
+// S[0..N-1], in order.  *Q may change as a result.  Return status.  (If *Q
+// has fewer than N, returns FALSE and leaves *Q unchanged.)
+
+bool removeManyQ (Queue *q, char **s, size_t n) {
+    Queue Q = *q;
+
+    if(sizeQ(q) < n) {
+        return false;
+    }
+    if(n == 0) {
+        return true;
+    }
+
+    getSlots(Q, s, n);
+    Q->head = (Q->head + n) & Q->mask;
+    Q->count -= n;
+    return true;
+}
+
+// Return the number of string pointers in Queue *Q.
+
+size_t sizeQ (Queue *q) {
+    return *q ? (*q)->count : 0;
+}
@@ -0,0 +1,63 @@
+/******************************************************************************
+ * RunStats.c
+ * Run a command and record its time and peak memory
+ *
+ *   RunStats FILE COMMAND [ARG]*
+ *
+ * Runs COMMAND with the given arguments, standard input and output, waits
+ * for it, and writes to FILE its elapsed seconds and its peak resident set
+ * size in kilobytes, as reported by wait4().  Exits with COMMAND's status.
+ *
+ * Harrison Miller
+ ******************************************************************************/
+
+#define _DEFAULT_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/time.h>
+#include <sys/wait.h>
+
+// Print message to stderr and exit.
+#define DIE(msg) exit (fprintf (stderr, "%s\n", msg));
+
+static double now(void) {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+int main(int argc, char **argv) {
+    struct rusage usage;
+    double start;
+    int status;
+    pid_t pid;
+    FILE *fp;
+
+    if(argc < 3) {
+        DIE("usage: RunStats FILE COMMAND [ARG]*");
+    }
+
+    start = now();
+    if((pid = fork()) < 0) {
+        DIE("fork() failed");
+    } else if (pid == 0) {
+        execvp(argv[2], argv + 2);
+        perror(argv[2]);
+        _exit(127);
+    }
+    if(wait4(pid, &status, 0, &usage) < 0) {
+        DIE("wait4() failed");
+    }
+
+    if(!(fp = fopen(argv[1], "w"))) {
+        DIE("cannot open FILE");
+    }
+    fprintf(fp, "%.3f %ld\n", now() - start, usage.ru_maxrss);
+    fclose(fp);
+
+    return WIFEXITED(status) ? WEXITSTATUS(status) : EXIT_FAILURE;
+}
@@ -0,0 +1,162 @@
+/******************************************************************************
+ * Runs.c
+ * Sorted runs on temporary files, for sorting more lines than fit in memory
+ *
+ * A run is a temporary file of lines in sorted order, one per line.  Runs are
+ * merged by reading one line at a time from each, so merging needs memory for
+ * only one line per run no matter how long the runs are.
+ *
+ * So that no more than a few hundred runs are open at once however many are
+ * spilled, a Runs merges them as they come, like the digits of a counter in
+ * base MAX_FANIN: each run has a level, 0 when spilled, and whenever the last
+ * MAX_FANIN runs have the same level they are merged into one run of the next
+ * level.  Levels never increase along the list, so only consecutive runs are
+ * merged, which keeps the sort stable, and each line is merged about
+ * log(runs) / log(MAX_FANIN) times.  Input files that
+ * are already sorted are merged the same way (Merge16 -m).
+ *
+ * HWK #4
+ * Merging Queues
+ *
+ * Harrison Miller
+ ******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+
+#include "/c/cs223/Hwk4/Queue.h"
+#include "Merge16.h"
+
+#define MAX_FANIN 256           // most run files merged at once
+
+struct runs {
+    FILE **fp;                  // the runs, in the order of their lines
+    int *level;                 // merges that made each run (see above)
+    int n, cap;                 // runs, and room for them
+    int pos, len;               // the key of their lines
+};
+
+// Write the lines in *Q to a new temporary file, removing them from *Q and
+// freeing them.  Return the file, rewound to its start.
+
+FILE *spillRun(Queue *q) {
+    FILE *fp = tmpfile();
+    char *line;
+
+    if(!fp) {
+        DIE("tmpfile() failed");
+    }
+    while(!isEmptyQ(q)) {
+        REMOVEQ(q, &line);
+        putLine(line, fp);
+        freeLine(line);
+    }
+    if(fflush(fp) != 0) {
+        DIE("cannot write temporary file");
+    }
+    rewind(fp);
+    return fp;
+}
+
+// Merge the K files IN[0..K-1], sorted by the key POS and LEN, into OUT with
+// a loser tree, closing them.  Lines with equal keys come out in the order of
+// their files.  If CHECK, die as soon as a file is found to have a line whose
+// key is less than the one before it.
+
+void mergeFiles(FILE *in[], int k, FILE *out, int pos, int len, bool check) {
+    char **heads = malloc(k * sizeof(char*));   // first line of each file
+    char *buf = NULL;                           // for readLine()
+    size_t cap = 0;
+    LoserTree t;
+    char *line, *next;
+    int i;
+
+    if(!heads) {
+        DIE("malloc() failed");
+    }
+    for(i = 0; i < k; i++) {
+        heads[i] = readLine(in[i], &buf, &cap, pos, len);
+    }
+    t = createTree(heads, k);
+
+    while((i = winnerTree(t, &line)) >= 0) {
+        next = readLine(in[i], &buf, &cap, pos, len);
+        if(check && next && compareLines(line, next) > 0) {
+            DIE("input not sorted");
+        }
+        putLine(line, out);
+        freeLine(line);
+        replaceTree(t, next);
+    }
+
+    if(fflush(out) != 0) {
+        DIE("write failed");
+    }
+    destroyTree(t);
+    for(i = 0; i < k; i++) {
+        fclose(in[i]);
+    }
+    free(heads);
+    free(buf);
+}
+
+// Return a new empty list of runs of lines keyed by POS and LEN.
+
+Runs createRuns(int pos, int len) {
+    Runs r = malloc(sizeof(*r));
+
+    if(!r) {
+        DIE("malloc() failed");
+    }
+    *r = (struct runs){NULL, NULL, 0, 0, pos, len};
+    return r;
+}
+
+// Merge runs R[FIRST..N-1] into one of level LEVEL, which takes their place.
+
+static void mergeLast(Runs r, int first, int level) {
+    FILE *merged = tmpfile();
+
+    if(!merged) {
+        DIE("tmpfile() failed");
+    }
+    mergeFiles(r->fp + first, r->n - first, merged, r->pos, r->len, false);
+    rewind(merged);
+    r->fp[first] = merged;
+    r->level[first] = level;
+    r->n = first + 1;
+}
+
+// Add the run FP (whose lines come after those of every run in R) to R,
+// merging runs as they fill a level.
+
+void addRun(Runs r, FILE *fp) {
+    if(r->n == r->cap) {
+        r->cap = r->cap ? 2 * r->cap : MAX_FANIN;
+        if(!(r->fp = realloc(r->fp, r->cap * sizeof(FILE*)))
+           || !(r->level = realloc(r->level, r->cap * sizeof(int)))) {
+            DIE("realloc() failed");
+        }
+    }
+    r->fp[r->n] = fp;
+    r->level[r->n++] = 0;
+
+    while(r->n >= MAX_FANIN && r->level[r->n - MAX_FANIN] == r->level[r->n - 1]) {
+        mergeLast(r, r->n - MAX_FANIN, r->level[r->n - 1] + 1);
+    }
+}
+
+// Merge the runs in R into OUT and free R.
+
+void finishRuns(Runs r, FILE *out) {
+    // there may be up to MAX_FANIN - 1 runs of each level left: merge the
+    // last MAX_FANIN of them until one pass will do
+    while(r->n > MAX_FANIN) {
+        mergeLast(r, r->n - MAX_FANIN, 0);
+    }
+    mergeFiles(r->fp, r->n, out, r->pos, r->len, false);
+    free(r->fp);
+    free(r->level);
+    free(r);
+}
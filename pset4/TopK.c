@@ -0,0 +1,129 @@
+/******************************************************************************
+ * TopK.c
+ * The first K lines of the sorted output, without sorting the rest
+ *
+ * The K least lines seen so far are kept in a max-heap, whose root is the
+ * greatest of them.  A new line that comes before the root replaces it, and
+ * any other line is thrown away at once, so N lines cost O(N log K) time and
+ * the memory for K lines.  Lines with equal keys are ordered by when they
+ * were read, as in the full sort: a new line never comes before a kept line
+ * with an equal key, so it only gets in if there is room.  At the end the
+ * heap is sorted in place (heapsort) and printed.
+ *
+ * HWK #4
+ * Merging Queues
+ *
+ * Harrison Miller
+ ******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+
+#include "/c/cs223/Hwk4/Queue.h"
+#include "Merge16.h"
+
+// A kept line, and how many lines were read before it.
+typedef struct entry {
+    char *line;
+    long seq;
+} Entry;
+
+struct topK {
+    long k;                 // most lines to keep
+    long n;                 // lines kept, heap[0..n-1]
+    long size;              // room in heap
+    long seq;               // lines offered so far
+    Entry *heap;
+};
+
+// Return true if entry A comes after entry B in the output.
+
+static bool after(const Entry *a, const Entry *b) {
+    int cmp = compareLines(a->line, b->line);
+
+    return cmp > 0 || (cmp == 0 && a->seq > b->seq);
+}
+
+// Move HEAP[I] down until it comes after neither of its children in
+// HEAP[0..N-1].
+
+static void siftDown(Entry *heap, long n, long i) {
+    Entry e = heap[i];
+
+    for(long c; (c = 2 * i + 1) < n; i = c) {
+        if(c + 1 < n && after(&heap[c + 1], &heap[c])) {
+            c++;
+        }
+        if(!after(&heap[c], &e)) {
+            break;
+        }
+        heap[i] = heap[c];
+    }
+    heap[i] = e;
+}
+
+// Return an empty TopK that keeps the first K lines.
+
+TopK createTopK(long k) {
+    TopK t = malloc(sizeof(*t));
+
+    if(!t) {
+        DIE("malloc() failed");
+    }
+    *t = (struct topK){k, 0, 0, 0, NULL};
+    return t;
+}
+
+// Offer LINE to T.  T keeps it if it is among the first K lines so far (a
+// copy of it if it is mapped, so mapped lines can be released once offered)
+// and frees it or whichever kept line it displaces.
+
+void offerTopK(TopK t, char *line) {
+    Entry e = {line, t->seq++};
+
+    if(t->n < t->k) {
+        long i = t->n++;
+
+        if(t->n > t->size) {
+            t->size = t->size ? 2 * t->size : 64;
+            if(t->size > t->k) {
+                t->size = t->k;
+            }
+            if(!(t->heap = realloc(t->heap, t->size * sizeof(Entry)))) {
+                DIE("realloc() failed");
+            }
+        }
+        e.line = LINE(line)->mapped ? copyLine(line) : line;
+        for(; i > 0 && after(&e, &t->heap[(i - 1) / 2]); i = (i - 1) / 2) {
+            t->heap[i] = t->heap[(i - 1) / 2];
+        }
+        t->heap[i] = e;
+
+    } else if (t->k > 0 && compareLines(line, t->heap[0].line) < 0) {
+        freeLine(t->heap[0].line);
+        e.line = LINE(line)->mapped ? copyLine(line) : line;
+        t->heap[0] = e;
+        siftDown(t->heap, t->n, 0);
+
+    } else {
+        freeLine(line);
+    }
+}
+
+// Print the lines T has kept in order to FP, free them, and destroy T.
+
+void printTopK(TopK t, FILE *fp) {
+    for(long n = t->n - 1; n > 0; n--) {
+        Entry e = t->heap[0];
+        t->heap[0] = t->heap[n];
+        t->heap[n] = e;
+        siftDown(t->heap, n, 0);
+    }
+    for(long i = 0; i < t->n; i++) {
+        putLine(t->heap[i].line, fp);
+        freeLine(t->heap[i].line);
+    }
+    free(t->heap);
+    free(t);
+}
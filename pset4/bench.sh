@@ -0,0 +1,96 @@
+#!/bin/bash
+#
+#       Created by Harrison Miller
+#       Course CS223, Spring 2016
+#       Problem Set 4
+#
+#       bench.sh: throughput, memory and differential check of Merge16
+#
+#       usage: ./bench.sh
+#
+#       For every corpus made by MergeGen, key and input order, sorts the
+#       input with GNU sort (LC_ALL=C sort -s, with the key as a character
+#       range of the whole line) and with ./Merge16 in each mode, reporting
+#       lines/s and peak RSS for each and whether Merge16's output matches
+#       sort's.  Exits nonzero if any output differs.
+#
+#       CORPORA lists KIND:N:MIN:MAX (see MergeGen.c), KEYS Merge16 keys
+#       (-POS or -POS,LEN), ORDERS any of random, sorted, reverse and few,
+#       and MODES Merge16 options ("merge" for none), all overridable from
+#       the environment.  -M8K spills thousands of runs, more than Runs.c
+#       merges at once, so it checks the merging of runs as they come.
+
+CORPORA=${CORPORA:-"short:1000000:8:24 long:100000:100:300"}
+KEYS=${KEYS:-"-0 -5,10"}
+ORDERS=${ORDERS:-"random sorted reverse few"}
+MODES=${MODES:-"merge -eradix -z -j4 -M16M -M8K"}
+
+TMP=$(mktemp -d)
+trap 'rm -rf "$TMP"' EXIT
+export LC_ALL=C
+status=0
+
+# print the sort(1) key option equivalent to Merge16 key $1, for fields
+# separated by \001: that never occurs in a line, so field 1 is the whole
+# line, and field 2 is empty
+sortKey() {
+    local pos=${1#-} len
+    if [[ $pos == *,* ]]; then
+        len=${pos#*,}
+        pos=${pos%,*}
+        if [ "$len" -eq 0 ]; then
+            echo "-k2,2"
+        else
+            printf -- "-k1.%d,1.%d\n" $((pos + 1)) $((pos + len))
+        fi
+    else
+        printf -- "-k1.%d\n" $((pos + 1))
+    fi
+}
+
+# time COMMAND... with its output in $TMP/out, and print lines/s and peak MB
+timed() {
+    ./RunStats "$TMP/stats" "$@" > "$TMP/out"
+    read -r secs kb < "$TMP/stats"
+    awk -v n="$lines" -v s="$secs" -v kb="$kb" 'BEGIN {
+        printf "%12.0f %8.1f", n / (s > 0 ? s : 0.001), kb / 1024
+    }'
+}
+
+printf "%-6s %-7s %-8s %-8s %12s %8s  %s\n" corpus key order mode lines/s peakMB output
+for corpus in $CORPORA; do
+    IFS=: read -r kind lines min max <<< "$corpus"
+
+    for key in $KEYS; do
+        skey=$(sortKey "$key")
+        for order in $ORDERS; do
+            case $order in
+            random|few)
+                ./MergeGen "$order" "$lines" "$min" "$max" 1 > "$TMP/in" ;;
+            sorted)
+                ./MergeGen random "$lines" "$min" "$max" 1 | sort -s -t $'\001' $skey > "$TMP/in" ;;
+            reverse)
+                ./MergeGen random "$lines" "$min" "$max" 1 | sort -s -r -t $'\001' $skey > "$TMP/in" ;;
+            esac
+
+            printf "%-6s %-7s %-8s %-8s %s  -\n" "$kind" "$key" "$order" sort \
+                "$(timed sort -s -t $'\001' $skey "$TMP/in")"
+            mv "$TMP/out" "$TMP/expected"
+
+            for mode in $MODES; do
+                opts=()
+                [ "$mode" != merge ] && opts=($mode)
+                stats=$(timed ./Merge16 "$key" "${opts[@]}" "$TMP/in")
+                if cmp -s "$TMP/out" "$TMP/expected"; then
+                    result=ok
+                else
+                    result=DIFFERS
+                    status=1
+                fi
+                printf "%-6s %-7s %-8s %-8s %s  %s\n" "$kind" "$key" "$order" "$mode" \
+                    "$stats" "$result"
+            done
+        done
+    done
+done
+exit $status
@@ -0,0 +1,159 @@
+/******************************************************************************
+ * benchConcQueue.c
+ * Benchmark and check of the lock-free queues in ConcQueue.c
+ *
+ *   benchConcQueue [N [THREADS]]
+ *
+ * Passes N strings from one producer thread to one consumer through an
+ * SpscQueue, and then N from each of THREADS producers to THREADS consumers
+ * through an MpmcQueue, both with room for 1024.  Prints nanoseconds per
+ * string, and checks that every string arrived exactly once, and that each
+ * consumer saw each producer's strings in the order they were added.  Exits
+ * nonzero if not.
+ *
+ * Harrison Miller
+ ******************************************************************************/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <time.h>
+#include <pthread.h>
+
+#include "ConcQueue.h"
+
+// Print message to stderr and exit.
+#define DIE(msg) exit (fprintf (stderr, "%s\n", msg));
+
+#define SIZE 1024               // room in each queue
+
+static long n = 1000000;        // strings per producer
+static int threads = 4;
+static char *item;              // producer p sends &item[p*n + i], in order
+static unsigned char *seen;     // how many times each item arrived
+static bool ok = true;
+
+static SpscQueue spsc;
+static MpmcQueue mpmc;
+
+static double now(void) {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+static void *produceSpsc(void *arg) {
+    for(long i = 0; i < n; i++) {
+        int spins = 0;
+        while(!addSpsc(spsc, &item[i])) {
+            backoff(&spins);
+        }
+    }
+    return NULL;
+}
+
+static void *produceMpmc(void *arg) {
+    long p = (long)arg;
+
+    for(long i = 0; i < n; i++) {
+        int spins = 0;
+        while(!addMpmc(mpmc, &item[p * n + i])) {
+            backoff(&spins);
+        }
+    }
+    return NULL;
+}
+
+// Take N strings (each producer's share) from the MpmcQueue, checking the
+// order of each producer's.
+
+static void *consumeMpmc(void *arg) {
+    long *last = malloc(threads * sizeof(long));    // last item from each
+    char *s;
+
+    if(!last) {
+        DIE("malloc() failed");
+    }
+    for(int p = 0; p < threads; p++) {
+        last[p] = -1;
+    }
+    for(long i = 0; i < n; i++) {
+        int spins = 0;
+        long k, p;
+        while(!removeMpmc(mpmc, &s)) {
+            backoff(&spins);
+        }
+        k = s - item;
+        p = k / n;
+        if(k % n <= last[p]) {
+            ok = false;
+        }
+        last[p] = k % n;
+        __atomic_add_fetch(&seen[k], 1, __ATOMIC_RELAXED);
+    }
+    free(last);
+    return NULL;
+}
+
+int main(int argc, char **argv) {
+    pthread_t *tid;
+    double start;
+    char *s;
+
+    if(argc > 1) {
+        n = atol(argv[1]);
+    }
+    if(argc > 2) {
+        threads = atoi(argv[2]);
+    }
+    if(n < 1 || threads < 1) {
+        DIE("usage: benchConcQueue [N [THREADS]]");
+    }
+    if(!(item = malloc(threads * n)) || !(seen = calloc(threads * n, 1))
+       || !(tid = malloc(2 * threads * sizeof(pthread_t)))
+       || !(spsc = createSpsc(SIZE)) || !(mpmc = createMpmc(SIZE))) {
+        DIE("malloc() failed");
+    }
+
+    start = now();
+    pthread_create(&tid[0], NULL, produceSpsc, NULL);
+    for(long i = 0; i < n; i++) {
+        int spins = 0;
+        while(!removeSpsc(spsc, &s)) {
+            backoff(&spins);
+        }
+        if(s != &item[i]) {
+            ok = false;
+        }
+    }
+    pthread_join(tid[0], NULL);
+    printf("spsc  1 -> 1  %6.1f ns/string\n", (now() - start) * 1e9 / n);
+
+    start = now();
+    for(long t = 0; t < threads; t++) {
+        pthread_create(&tid[t], NULL, produceMpmc, (void*)t);
+        pthread_create(&tid[threads + t], NULL, consumeMpmc, NULL);
+    }
+    for(int t = 0; t < 2 * threads; t++) {
+        pthread_join(tid[t], NULL);
+    }
+    printf("mpmc %2d -> %-2d %6.1f ns/string\n", threads, threads,
+           (now() - start) * 1e9 / (n * threads));
+    for(long k = 0; k < threads * n; k++) {
+        if(seen[k] != 1) {
+            ok = false;
+        }
+    }
+
+    destroySpsc(spsc);
+    destroyMpmc(mpmc);
+    free(item);
+    free(seen);
+    free(tid);
+    if(!ok) {
+        DIE("FAILED: strings lost, duplicated or out of order");
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,141 @@
+/******************************************************************************
+ * benchQueue.c
+ * Benchmark for implementations of the Queue ADT
+ *
+ * Times the queue operations in the patterns Merge16 uses them:
+ *
+ *   fill/drain   add N strings, then remove them all
+ *   steady       remove one string and add one, with N strings queued
+ *   merge        the passes of a bottom-up merge sort of N strings between
+ *                two queues (headQ twice, removeQ and addQ per string)
+ *
+ *   benchQueue [N [ROUNDS]]
+ *
+ * It is linked with Queue.o as benchQueue and with RingQueue.o as
+ * benchRingQueue, and prints nanoseconds per operation for each pattern.
+ *
+ * Harrison Miller
+ ******************************************************************************/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <time.h>
+
+#include "/c/cs223/Hwk4/Queue.h"
+
+// Print message to stderr and exit.
+#define DIE(msg) exit (fprintf (stderr, "%s\n", msg));
+
+#define ADDQ(Q,S) if(!addQ(Q,S)) DIE("addQ() failed");
+#define CREATEQ(Q) if(!createQ(Q)) DIE("createQ() failed");
+#define REMOVEQ(Q,S) if(!removeQ(Q,S)) DIE("removeQ() failed");
+#define DESTROYQ(Q) if(!destroyQ(Q)) DIE("destroyQ() failed");
+
+static double now (void) {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+static void report (const char *name, double secs, double ops) {
+    printf("%-12s %8.2f ns/op  (%.0f ops in %.3f s)\n", name, secs * 1e9 / ops, ops, secs);
+}
+
+int main(int argc, char **argv) {
+    long n = argc > 1 ? atol(argv[1]) : 1000000;
+    int rounds = argc > 2 ? atoi(argv[2]) : 3;
+    char **strings = malloc(n * sizeof(char*));
+    char *s, *s1, *s2;
+    Queue Q, Q1, Q2;
+    double t;
+    long ops;
+
+    if(n < 1 || rounds < 1) {
+        DIE("usage: benchQueue [N [ROUNDS]]");
+    }
+    if(!strings) {
+        DIE("malloc() failed");
+    }
+    for(long i = 0; i < n; i++) {
+        strings[i] = (char*)&strings[(i * 7919) % n]; // distinct, in a scrambled order
+    }
+
+    // fill/drain
+    t = now();
+    for(int r = 0; r < rounds; r++) {
+        CREATEQ(&Q);
+        for(long i = 0; i < n; i++) {
+            ADDQ(&Q, strings[i]);
+        }
+        for(long i = 0; i < n; i++) {
+            REMOVEQ(&Q, &s);
+        }
+        DESTROYQ(&Q);
+    }
+    report("fill/drain", now() - t, 2.0 * n * rounds);
+
+    // steady
+    CREATEQ(&Q);
+    for(long i = 0; i < n; i++) {
+        ADDQ(&Q, strings[i]);
+    }
+    t = now();
+    for(long i = 0; i < n * rounds; i++) {
+        REMOVEQ(&Q, &s);
+        ADDQ(&Q, s);
+    }
+    report("steady", now() - t, 2.0 * n * rounds);
+    DESTROYQ(&Q);
+
+    // merge: runs of length b alternate between Q1 and Q2; each pass merges
+    // pairs of runs into runs of length 2b, dealt alternately to two new queues
+    ops = 0;
+    t = now();
+    for(int r = 0; r < rounds; r++) {
+        long c1 = (n + 1) / 2, c2 = n / 2; // strings in Q1 and Q2
+        CREATEQ(&Q1);
+        CREATEQ(&Q2);
+        for(long i = 0; i < n; i++) {
+            ADDQ(i % 2 ? &Q2 : &Q1, strings[i]);
+        }
+        for(long b = 1; c2 > 0; b *= 2) {
+            long n1 = 0, n2 = 0; // strings dealt to O1 and O2
+            Queue O1, O2;
+            CREATEQ(&O1);
+            CREATEQ(&O2);
+            for(bool toO1 = true; c1 > 0 || c2 > 0; toO1 = !toO1) {
+                long k1 = c1 < b ? c1 : b, k2 = c2 < b ? c2 : b;
+                c1 -= k1;
+                c2 -= k2;
+                *(toO1 ? &n1 : &n2) += k1 + k2;
+                while(k1 > 0 || k2 > 0) {
+                    bool both = k1 > 0 && k2 > 0; // compare only while both runs last
+                    bool take1 = k2 == 0 || (both && headQ(&Q1, &s1) && headQ(&Q2, &s2) && s1 <= s2);
+                    REMOVEQ(take1 ? &Q1 : &Q2, &s);
+                    ADDQ(toO1 ? &O1 : &O2, s);
+                    if(take1) {
+                        k1--;
+                    } else {
+                        k2--;
+                    }
+                    ops += both ? 4 : 2;
+                }
+            }
+            DESTROYQ(&Q1);
+            DESTROYQ(&Q2);
+            Q1 = O1;
+            Q2 = O2;
+            c1 = n1;
+            c2 = n2;
+        }
+        DESTROYQ(&Q1);
+        DESTROYQ(&Q2);
+    }
+    report("merge", now() - t, ops);
+
+    free(strings);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,142 @@
+/******************************************************************************
+ * testQueueExt.c
+ * Tests for implementations of the operations of QueueExt.h
+ *
+ * Checks appendQ, addManyQ, removeManyQ and sizeQ against the order and
+ * counts of plain addQ and removeQ, including the edge cases: an empty source
+ * queue, N == 0, N larger than the queue, a NULL string in a batch, and
+ * appending a queue to itself.
+ *
+ *   testQueueExt
+ *
+ * It is linked with Queue.o as testQueueExt, with RingQueue.o as
+ * testRingQueueExt, and with QueueExt.o and the course's Queue.o as
+ * testQueueExtH.  It prints the first failed check and exits with status 1,
+ * or prints a line saying all passed.
+ *
+ * Harrison Miller
+ ******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+
+#include "/c/cs223/Hwk4/Queue.h"
+#include "QueueExt.h"
+
+#define CHECK(c) if(!(c)) { fprintf(stderr, "FAIL %s:%d %s\n", __FILE__, __LINE__, #c); exit(1); }
+
+#define N 1000                  // strings in the longest queue
+
+static char str[N];             // string i is &str[i]
+static char *all[N];            // all[i] == &str[i]
+
+// Check that Queue *Q holds strings LO..HI-1 in order by removing them, and
+// that it is then empty.
+
+static void drain (Queue *q, int lo, int hi) {
+    char *s;
+
+    CHECK(sizeQ(q) == (size_t) (hi - lo));
+    for(int i = lo; i < hi; i++) {
+        CHECK(removeQ(q, &s));
+        CHECK(s == all[i]);
+    }
+    CHECK(isEmptyQ(q));
+    CHECK(sizeQ(q) == 0);
+}
+
+// Add strings LO..HI-1 to Queue *Q one at a time.
+
+static void fill (Queue *q, int lo, int hi) {
+    for(int i = lo; i < hi; i++) {
+        CHECK(addQ(q, all[i]));
+    }
+}
+
+int main (void) {
+    Queue p, q;
+    char *s[N+1];
+
+    for(int i = 0; i < N; i++) {
+        all[i] = &str[i];
+    }
+    CHECK(createQ(&p));
+    CHECK(createQ(&q));
+
+    // sizeQ
+    CHECK(sizeQ(&p) == 0);
+    fill(&p, 0, N);
+    CHECK(sizeQ(&p) == N);
+    CHECK(sizeQ(&p) == N);                      // counting changes nothing
+    drain(&p, 0, N);
+
+    // appendQ: empty source, empty destination, both nonempty
+    CHECK(appendQ(&p, &q));
+    CHECK(isEmptyQ(&p) && isEmptyQ(&q));
+    fill(&p, 0, 10);
+    CHECK(appendQ(&p, &q));
+    CHECK(isEmptyQ(&q));
+    CHECK(appendQ(&q, &p));
+    CHECK(isEmptyQ(&p));
+    fill(&p, 10, 25);
+    CHECK(appendQ(&q, &p));
+    CHECK(isEmptyQ(&p) && sizeQ(&p) == 0);
+    CHECK(addQ(&p, all[0]));                    // the source is still usable
+    CHECK(removeQ(&p, &s[0]) && s[0] == all[0]);
+    drain(&q, 0, 25);
+
+    // appendQ of a queue to itself fails and changes nothing
+    CHECK(!appendQ(&p, &p));
+    CHECK(isEmptyQ(&p));
+    fill(&p, 0, 5);
+    CHECK(!appendQ(&p, &p));
+    drain(&p, 0, 5);
+
+    // addManyQ: N == 0, onto an empty queue, onto a nonempty one
+    CHECK(addManyQ(&p, all, 0));
+    CHECK(isEmptyQ(&p));
+    CHECK(addManyQ(&p, all, 100));
+    CHECK(addManyQ(&p, all + 100, N - 100));
+    drain(&p, 0, N);
+
+    // addManyQ with a NULL string adds none of them
+    fill(&p, 0, 3);
+    s[0] = all[3];
+    s[1] = NULL;
+    CHECK(!addManyQ(&p, s, 2));
+    drain(&p, 0, 3);
+
+    // removeManyQ: N == 0, N larger than the queue, all of it, part of it
+    CHECK(removeManyQ(&p, s, 0));
+    CHECK(!removeManyQ(&p, s, 1));
+    fill(&p, 0, 50);
+    CHECK(removeManyQ(&p, s, 0));
+    CHECK(!removeManyQ(&p, s, 51));
+    CHECK(sizeQ(&p) == 50);
+    CHECK(removeManyQ(&p, s, 20));
+    for(int i = 0; i < 20; i++) {
+        CHECK(s[i] == all[i]);
+    }
+    CHECK(sizeQ(&p) == 30);
+    CHECK(removeManyQ(&p, s, 30));
+    for(int i = 0; i < 30; i++) {
+        CHECK(s[i] == all[20+i]);
+    }
+    CHECK(isEmptyQ(&p));
+
+    // all of them again once the ring has wrapped around (for RingQueue.c)
+    for(int round = 0; round < 3; round++) {
+        fill(&p, 0, 7);
+        CHECK(removeManyQ(&p, s, 5));
+        CHECK(addManyQ(&p, all + 7, 20));
+        fill(&q, 27, 40);
+        CHECK(appendQ(&p, &q));
+        drain(&p, 5, 40);
+    }
+
+    CHECK(destroyQ(&p));
+    CHECK(destroyQ(&q));
+    puts("testQueueExt: all tests passed");
+    return 0;
+}
@@ -1,6 +1,24 @@
 /******************************************************************************
  * Hash.c
- * Main routine for sorting two queues
+ * Open-addressing hash set of keys, for the states Pancake has visited
+ *
+ * Keys are kept inline in one array of slots whose size is a power of two,
+ * so a key's first slot is the top bits of a 64-bit mix of the key rather
+ * than the remainder of a division, and a collision goes on to the next slot
+ * (linear probing), which is usually in the same cache line.  The table
+ * doubles before it is half full, which keeps probe sequences short.  Since
+ * the top bits are used, a key in slot I of the old table goes to about slot
+ * 2I of the new one, so growing reads and writes memory in order.
+ *
+ * An empty slot holds the all-zero key, so that key itself is not stored in
+ * the table but remembered by a flag.
+ *
+ * A table of millions of keys is far bigger than the caches, so nearly every
+ * probe misses them and the TLB as well.  Such a table is mapped directly,
+ * already zeroed, and where the system has them in huge pages, which make
+ * TLB misses (and page faults as the table is first filled) 512 times rarer.
+ * Smaller tables come from calloc(), which can reuse memory already faulted
+ * in.
  *
  * HWK #5
  * Pancake Sort
@@ -8,19 +26,182 @@
  * Harrison Miller
  ******************************************************************************/
 
-// Return hash of string S into [0,SIZE)
-static long hash (char *s, long size)
-{
-    unsigned long sum;
-    int shift;
-    const unsigned long prime = 3141592653589793239L;
+#define _DEFAULT_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <sys/mman.h>
+
+#include "Hash.h"
+#include "Pancake.h"
+
+#define MIN_SLOTS 16            // fewest slots in a table (a power of two)
+#define MAP_BYTES (1 << 21)     // smallest table to map (one huge page)
+
+struct hash {
+    Key *slot;                  // the keys, and all-zero keys where empty
+    uint64_t mask;              // number of slots - 1
+    int shift;                  // 64 - log2(number of slots)
+    long count;                 // keys in the slots
+    long limit;                 // count at which to grow: half the slots
+    bool hasZero;               // the all-zero key is in the set
+};
+
+// Return a 64-bit hash of K.  The words are combined by multiplication, which
+// carries every bit of the first upward, and then mixed as in the finalizer
+// of MurmurHash3, so every bit of the key affects the top bits of the hash
+// that choose a slot.
+
+static inline uint64_t mix (Key k) {
+    uint64_t x = k.w[0] * 0x9e3779b97f4a7c15ULL ^ k.w[1];
+
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdULL;
+    x ^= x >> 33;
+    x *= 0xc4ceb9fe1a85ec53ULL;
+    x ^= x >> 33;
+    return x;
+}
+
+static inline bool isZero (Key k) {
+    return (k.w[0] | k.w[1]) == 0;
+}
+
+static inline bool equal (Key a, Key b) {
+    return ((a.w[0] ^ b.w[0]) | (a.w[1] ^ b.w[1])) == 0;
+}
+
+// Set H's table to SIZE empty slots (a power of two).
+
+static void allocSlots (Hash h, uint64_t size) {
+    size_t bytes = size * sizeof(Key);
+
+    if(bytes < MAP_BYTES) {
+        if(!(h->slot = calloc(size, sizeof(Key)))) {
+            DIE("calloc() failed");
+        }
+    } else {
+        void *addr = mmap(NULL, bytes, PROT_READ | PROT_WRITE,
+                          MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if(addr == MAP_FAILED) {
+            DIE("mmap() failed");
+        }
+#ifdef MADV_HUGEPAGE
+        madvise(addr, bytes, MADV_HUGEPAGE);              // only a hint
+#endif
+        h->slot = addr;
+    }
+    h->mask = size - 1;
+    h->limit = size / 2;
+    for(h->shift = 64; size > 1; size /= 2) {
+        h->shift--;
+    }
+}
+
+// Free the table of slots of H.
+
+static void freeSlots (Hash h) {
+    size_t bytes = (h->mask + 1) * sizeof(Key);
+
+    if(bytes < MAP_BYTES) {
+        free(h->slot);
+    } else {
+        munmap(h->slot, bytes);
+    }
+}
+
+// Double the number of slots in H and put the keys back in.
 
-    for (sum = 0, shift = 0; *s; s++) {
-    sum ^= *s<<shift;
-    shift += 7;
-    if (shift >= 57)
-        shift -= 57;
+static void grow (Hash h) {
+    struct hash old = *h;
+    uint64_t size = h->mask + 1;
+
+    allocSlots(h, 2 * size);
+    for(uint64_t i = 0; i < size; i++) {
+        if(!isZero(old.slot[i])) {
+            uint64_t j = mix(old.slot[i]) >> h->shift;
+            while(!isZero(h->slot[j])) {
+                j = (j + 1) & h->mask;
+            }
+            h->slot[j] = old.slot[i];
+        }
+    }
+    freeSlots(&old);
+}
+
+// Return a new empty set with room for about N keys before it grows.
+
+Hash createHash(long n) {
+    Hash h = malloc(sizeof(*h));
+    uint64_t size = MIN_SLOTS;
+
+    if(!h) {
+        DIE("malloc() failed");
+    }
+    while((long) (size / 2) < n) {
+        size *= 2;
+    }
+    allocSlots(h, size);
+    h->count = 0;
+    h->hasZero = false;
+    return h;
+}
+
+// Add K to H if it is not already there.  Return true if it was added, false
+// if it was found.
+
+bool insertHash(Hash h, Key k) {
+    uint64_t i;
+
+    if(isZero(k)) {
+        bool added = !h->hasZero;
+        h->hasZero = true;
+        return added;
+    }
+
+    for(i = mix(k) >> h->shift; !isZero(h->slot[i]); i = (i + 1) & h->mask) {
+        if(equal(h->slot[i], k)) {
+            return false;
+        }
     }
 
-    return ((prime * sum) % size);
+    if(h->count >= h->limit) {
+        // full enough to grow: the empty slot found is not where k will go
+        grow(h);
+        for(i = mix(k) >> h->shift; !isZero(h->slot[i]); i = (i + 1) & h->mask) {
+        }
+    }
+    h->slot[i] = k;
+    h->count++;
+    return true;
+}
+
+// Return true if K is in H.
+
+bool findHash(Hash h, Key k) {
+    if(isZero(k)) {
+        return h->hasZero;
+    }
+
+    for(uint64_t i = mix(k) >> h->shift; !isZero(h->slot[i]); i = (i + 1) & h->mask) {
+        if(equal(h->slot[i], k)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Return the number of keys in H.
+
+long sizeHash(Hash h) {
+    return h->count + h->hasZero;
+}
+
+// Free the storage used by H.
+
+void destroyHash(Hash h) {
+    freeSlots(h);
+    free(h);
 }
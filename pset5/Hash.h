@@ -0,0 +1,39 @@
+/******************************************************************************
+ * Hash.h
+ * Set of fixed-length keys, for the states a search has visited
+ *
+ * Harrison Miller
+ ******************************************************************************/
+
+#ifndef HASH_H
+#define HASH_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// A key: a state packed into two 64-bit words.  Keys are compared and stored
+// by value, never by pointer.
+typedef struct key {
+    uint64_t w[2];
+} Key;
+
+typedef struct hash *Hash;
+
+// Return a new empty set with room for about N keys before it grows.
+Hash createHash(long n);
+
+// Add K to H if it is not already there.  Return true if it was added, false
+// if it was found.
+bool insertHash(Hash h, Key k);
+
+// Return true if K is in H.
+bool findHash(Hash h, Key k);
+
+// Return the number of keys in H.
+long sizeHash(Hash h);
+
+// Free the storage used by H.
+void destroyHash(Hash h);
+
+#endif
+/* end HASH_H */
@@ -0,0 +1,149 @@
+/******************************************************************************
+ * State.c
+ * Converting Pancake states between strings and packed States
+ *
+ * Each character that appears in INITIAL or GOAL gets a code, in the order
+ * of the characters, so a state's tiles take 4 bits each if there are at
+ * most 16 different ones and 5 bits if there are at most 32.  Tile I goes in
+ * word I / PER_WORD at bit (I % PER_WORD) * BITS, where PER_WORD is as many
+ * tiles as fit whole in 64 bits (16 or 12), so no tile straddles the words: a
+ * State holds up to 32 tiles of 4 bits or 24 of 5.  Unused bits are zero, so
+ * equal states are equal words.
+ *
+ * HWK #5
+ * Pancake Sort
+ *
+ * Harrison Miller
+ ******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "State.h"
+#include "Pancake.h"
+
+#define MAX_CODES 32            // most different tiles (5 bits each)
+
+struct packing {
+    int tiles;                  // tiles in a state
+    int bits;                   // bits in a tile's code (4 or 5)
+    int perWord;                // tiles in a word
+    uint64_t mask;              // the low BITS bits
+    signed char code[256];      // code of each character, or -1 if none
+    char tile[MAX_CODES];       // character of each code
+};
+
+// Return a packing for states of the length of INITIAL whose tiles are the
+// characters in INITIAL and GOAL.  Die if there are more than 32 different
+// characters, or more tiles than fit in a State.
+
+Packing createPacking(const char *initial, const char *goal) {
+    Packing p = malloc(sizeof(*p));
+    bool seen[256] = {false};
+    int codes = 0;
+
+    if(!p) {
+        DIE("malloc() failed");
+    }
+    for(const char *s = initial; *s; s++) {
+        seen[(unsigned char) *s] = true;
+    }
+    for(const char *s = goal; *s; s++) {
+        seen[(unsigned char) *s] = true;
+    }
+
+    // codes go to the characters in order
+    for(int c = 0; c < 256; c++) {
+        p->code[c] = -1;
+        if(seen[c]) {
+            if(codes == MAX_CODES) {
+                DIE("too many different tiles");
+            }
+            p->tile[codes] = c;
+            p->code[c] = codes++;
+        }
+    }
+
+    p->tiles = strlen(initial);
+    p->bits = (codes <= 16) ? 4 : 5;
+    p->perWord = 64 / p->bits;
+    p->mask = ((uint64_t) 1 << p->bits) - 1;
+    if(p->tiles > 2 * p->perWord) {
+        DIE("too many tiles");
+    }
+    return p;
+}
+
+// Store in *ST the packed form of the string S.  Return status.  (If S is
+// not the length of P's states or has a character not in its alphabet,
+// returns FALSE and leaves *ST unchanged.)
+
+bool packState(Packing p, const char *s, State *st) {
+    State new = {{0, 0}};
+    int i;
+
+    for(i = 0; s[i]; i++) {
+        int code = p->code[(unsigned char) s[i]];
+        if(i == p->tiles || code < 0) {
+            return false;
+        }
+        new.w[i / p->perWord] |= (uint64_t) code << (i % p->perWord * p->bits);
+    }
+    if(i != p->tiles) {
+        return false;
+    }
+
+    *st = new;
+    return true;
+}
+
+// Store the string form of ST in S, which has room for the tiles and a null.
+
+void unpackState(Packing p, State st, char *s) {
+    for(int i = 0; i < p->tiles; i++) {
+        s[i] = p->tile[getTile(p, st, i)];
+    }
+    s[p->tiles] = '\0';
+}
+
+// Return the number of tiles in P's states.
+
+int tilesPacking(Packing p) {
+    return p->tiles;
+}
+
+// Return the code of tile I of ST.
+
+int getTile(Packing p, State st, int i) {
+    return (st.w[i / p->perWord] >> (i % p->perWord * p->bits)) & p->mask;
+}
+
+// Return ST with tile I set to CODE.
+
+State setTile(Packing p, State st, int i, int code) {
+    int shift = i % p->perWord * p->bits;
+    uint64_t *w = &st.w[i / p->perWord];
+
+    *w = (*w & ~(p->mask << shift)) | (uint64_t) code << shift;
+    return st;
+}
+
+// Return ST with tiles I..J-1 in reverse order (a flip).
+
+State reverseTiles(Packing p, State st, int i, int j) {
+    State new = st;
+
+    for(int k = i; k < j; k++) {
+        new = setTile(p, new, k, getTile(p, st, i + j - 1 - k));
+    }
+    return new;
+}
+
+// Free the storage used by P.
+
+void destroyPacking(Packing p) {
+    free(p);
+}
@@ -0,0 +1,58 @@
+/******************************************************************************
+ * State.h
+ * Pancake states packed into two 64-bit words
+ *
+ * Harrison Miller
+ ******************************************************************************/
+
+#ifndef STATE_H
+#define STATE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "Hash.h"
+
+// A state: its tiles in 4 or 5 bits each, so that comparing, copying and
+// hashing it take a few word operations, and it can go straight into a Hash.
+typedef Key State;
+
+// How the tiles of a puzzle are packed: which character each code stands
+// for, and how many bits a code takes.
+typedef struct packing *Packing;
+
+// Return a packing for states of the length of INITIAL whose tiles are the
+// characters in INITIAL and GOAL.  Die if there are more than 32 different
+// characters, or more tiles than fit in a State.
+Packing createPacking(const char *initial, const char *goal);
+
+// Store in *ST the packed form of the string S.  Return status.  (If S is
+// not the length of P's states or has a character not in its alphabet,
+// returns FALSE and leaves *ST unchanged.)
+bool packState(Packing p, const char *s, State *st);
+
+// Store the string form of ST in S, which has room for the tiles and a null.
+void unpackState(Packing p, State st, char *s);
+
+// Return the number of tiles in P's states.
+int tilesPacking(Packing p);
+
+// Return the code of tile I of ST.
+int getTile(Packing p, State st, int i);
+
+// Return ST with tile I set to CODE.
+State setTile(Packing p, State st, int i, int code);
+
+// Return ST with tiles I..J-1 in reverse order (a flip).
+State reverseTiles(Packing p, State st, int i, int j);
+
+// Free the storage used by P.
+void destroyPacking(Packing p);
+
+// Return true if states A and B are the same.
+static inline bool equalState(State a, State b) {
+    return ((a.w[0] ^ b.w[0]) | (a.w[1] ^ b.w[1])) == 0;
+}
+
+#endif
+/* end STATE_H */
@@ -0,0 +1,115 @@
+/******************************************************************************
+ * benchHash.c
+ * Benchmark for the Hash set
+ *
+ * Times insertHash() as a search uses it, to insert a state or find that it
+ * was visited:
+ *
+ *   random      N distinct random keys, each inserted twice (once new, once
+ *               found), in two passes, into a set that starts empty and grows
+ *   dense       the same with keys 1..N in the low bits of the first word,
+ *               like packed states that differ in only a few tiles
+ *   presized    the random keys again, into a set created with room for N
+ *
+ *   benchHash [N [ROUNDS]]
+ *
+ * and checks that every key was added once and found once.  Each pattern is
+ * run ROUNDS times with a new set; prints nanoseconds per insertHash() and
+ * millions of them per second.
+ *
+ * Harrison Miller
+ ******************************************************************************/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "Hash.h"
+#include "Pancake.h"
+
+static double now (void) {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+// Return the next number of a xorshift64* sequence with state *X.
+
+static uint64_t next (uint64_t *x) {
+    *x ^= *x >> 12;
+    *x ^= *x << 25;
+    *x ^= *x >> 27;
+    return *x * 0x2545f4914f6cdd1dULL;
+}
+
+// ROUNDS times, insert the N keys KEYS[] twice into a new set with room for
+// SIZE, and check that each was added the first time and found the second.
+// Print the time per insertHash().
+
+static void run (const char *name, Key *keys, long n, long size, int rounds) {
+    double start = now(), secs;
+
+    for(int r = 0; r < rounds; r++) {
+        Hash h = createHash(size);
+        long added = 0, found = 0;
+
+        for(int pass = 0; pass < 2; pass++) {
+            for(long i = 0; i < n; i++) {
+                if(insertHash(h, keys[i])) {
+                    added++;
+                } else {
+                    found++;
+                }
+            }
+        }
+        if(added != n || found != n || sizeHash(h) != n) {
+            DIE("wrong count");
+        }
+        destroyHash(h);
+    }
+    secs = now() - start;
+
+    printf("%-9s %10ld %8.1f ns %8.1f M/s\n", name, n,
+           secs * 1e9 / (2.0 * n * rounds), 2.0 * n * rounds / secs / 1e6);
+}
+
+int main(int argc, char **argv) {
+    long n = (argc > 1) ? atol(argv[1]) : 1000000;
+    int rounds = (argc > 2) ? atoi(argv[2]) : 3;
+    Key *keys = malloc(n * sizeof(Key));
+    uint64_t x = 88172645463325252ULL;
+
+    if(n < 1 || rounds < 1) {
+        DIE("usage: benchHash [N [ROUNDS]]");
+    }
+    if(!keys) {
+        DIE("malloc() failed");
+    }
+
+    // random keys are distinct with overwhelming probability
+    for(long i = 0; i < n; i++) {
+        keys[i].w[0] = next(&x);
+        keys[i].w[1] = next(&x);
+    }
+    run("random", keys, n, 0, rounds);
+
+    for(long i = 0; i < n; i++) {
+        keys[i].w[0] = i + 1;
+        keys[i].w[1] = 0;
+    }
+    run("dense", keys, n, 0, rounds);
+
+    x = 88172645463325252ULL;
+    for(long i = 0; i < n; i++) {
+        keys[i].w[0] = next(&x);
+        keys[i].w[1] = next(&x);
+    }
+    run("presized", keys, n, n, rounds);
+
+    free(keys);
+    return EXIT_SUCCESS;
+}
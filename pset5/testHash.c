@@ -0,0 +1,127 @@
+/******************************************************************************
+ * testHash.c
+ * Tests for the Hash set
+ *
+ * Checks with assert() that keys inserted are found and counted once, and
+ * keys not inserted are not found:
+ *
+ *   zero        the all-zero key, which is kept apart from the table
+ *   grow        N keys into a set created with room for 1, so it doubles
+ *               from the smallest table through the mmap()'d sizes
+ *   near        keys that differ in one bit of either word, and keys whose
+ *               first or second word is zero
+ *
+ *   testHash
+ *
+ * Prints a line saying all passed, or aborts at the first failed check.
+ *
+ * Harrison Miller
+ ******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <assert.h>
+
+#include "Hash.h"
+
+#define N 300000                // keys in the grow test (about 9 MB of slots)
+
+// Return the Ith key of the grow test: distinct for distinct I, nonzero, and
+// with both words varying.
+
+static Key nthKey (long i) {
+    Key k = {{(uint64_t) i * 0x9e3779b97f4a7c15 + 1, (uint64_t) i >> 3}};
+    return k;
+}
+
+static void testZero (void) {
+    Hash h = createHash(4);
+    Key zero = {{0, 0}};
+
+    assert(!findHash(h, zero));
+    assert(sizeHash(h) == 0);
+    assert(insertHash(h, zero));
+    assert(findHash(h, zero));
+    assert(!insertHash(h, zero));
+    assert(sizeHash(h) == 1);
+
+    // the zero key is not mistaken for any other, nor they for it
+    for(int b = 0; b < 64; b++) {
+        Key k0 = {{(uint64_t) 1 << b, 0}}, k1 = {{0, (uint64_t) 1 << b}};
+        assert(!findHash(h, k0) && !findHash(h, k1));
+        assert(insertHash(h, k0) && insertHash(h, k1));
+    }
+    assert(sizeHash(h) == 129);
+    assert(findHash(h, zero));
+    destroyHash(h);
+
+    // nor is it there in a set that has grown without it
+    h = createHash(1);
+    for(long i = 0; i < 1000; i++) {
+        assert(insertHash(h, nthKey(i)));
+    }
+    assert(!findHash(h, zero));
+    assert(sizeHash(h) == 1000);
+    destroyHash(h);
+}
+
+static void testGrow (void) {
+    Hash h = createHash(1);
+
+    for(long i = 0; i < N; i++) {
+        assert(insertHash(h, nthKey(i)));
+        assert(sizeHash(h) == i + 1);
+        if((i & (i + 1)) == 0) {
+            // just past a power of two: everything so far survived growing
+            for(long j = 0; j <= i; j++) {
+                assert(findHash(h, nthKey(j)));
+            }
+        }
+    }
+    for(long i = 0; i < N; i++) {
+        assert(findHash(h, nthKey(i)));
+        assert(!insertHash(h, nthKey(i)));
+    }
+    for(long i = N; i < 2 * N; i++) {
+        assert(!findHash(h, nthKey(i)));
+    }
+    assert(sizeHash(h) == N);
+    destroyHash(h);
+}
+
+static void testNear (void) {
+    Hash h = createHash(16);
+    Key base = {{0x0123456789abcdef, 0xfedcba9876543210}};
+    long n = 1;
+
+    assert(insertHash(h, base));
+    for(int w = 0; w < 2; w++) {
+        for(int b = 0; b < 64; b++) {
+            Key k = base;
+            k.w[w] ^= (uint64_t) 1 << b;
+            assert(!findHash(h, k));
+            assert(insertHash(h, k));
+            n++;
+        }
+    }
+    for(int w = 0; w < 2; w++) {
+        Key k = base;
+        k.w[w] = 0;
+        assert(!findHash(h, k));
+        assert(insertHash(h, k));
+        n++;
+    }
+    assert(sizeHash(h) == n);
+    assert(findHash(h, base) && !insertHash(h, base));
+    destroyHash(h);
+}
+
+int main (void) {
+    testZero();
+    testGrow();
+    testNear();
+    puts("testHash: all tests passed");
+    return 0;
+}
@@ -0,0 +1,132 @@
+/******************************************************************************
+ * testState.c
+ * Tests for packing Pancake states
+ *
+ * Checks with assert() that, at both tile widths (4 bits for at most 16
+ * different tiles, 5 bits for up to 32) and at every length up to the most
+ * that fit:
+ *
+ *   round trip  unpackState(packState(S)) == S, and equal strings, and only
+ *               they, pack to equal states
+ *   tiles       getTile(), setTile() and reverseTiles() match the same
+ *               operations on the string
+ *   reject      packState() fails, and leaves the state alone, on a string of
+ *               the wrong length or with a character not in the alphabet
+ *
+ *   testState
+ *
+ * Prints a line saying all passed, or aborts at the first failed check.
+ *
+ * Harrison Miller
+ ******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <assert.h>
+
+#include "State.h"
+
+#define MAX_TILES 32            // most tiles in a State (at 4 bits)
+#define TRIALS 2000             // random strings per alphabet and length
+
+// Set S to N random characters from ALPHA and a null.
+
+static void randomString (char *s, int n, const char *alpha) {
+    int codes = strlen(alpha);
+
+    for(int i = 0; i < n; i++) {
+        s[i] = alpha[rand() % codes];
+    }
+    s[n] = '\0';
+}
+
+// Reverse S[I..J-1] in place.
+
+static void reverseString (char *s, int i, int j) {
+    for(j--; i < j; i++, j--) {
+        char c = s[i];
+        s[i] = s[j];
+        s[j] = c;
+    }
+}
+
+// Run the checks for strings of N tiles from the characters in ALPHA.
+
+static void testPacking (const char *alpha, int n) {
+    char a[MAX_TILES+2], b[MAX_TILES+2], out[MAX_TILES+2];
+    Packing p;
+    State sa, sb, st;
+
+    // a goal of the whole alphabet gives character ALPHA[I] code I
+    randomString(a, n, alpha);
+    p = createPacking(a, alpha);
+    assert(tilesPacking(p) == n);
+
+    for(int t = 0; t < TRIALS; t++) {
+        randomString(a, n, alpha);
+        randomString(b, n, alpha);
+
+        // round trip
+        assert(packState(p, a, &sa));
+        assert(packState(p, b, &sb));
+        unpackState(p, sa, out);
+        assert(strcmp(out, a) == 0);
+        unpackState(p, sb, out);
+        assert(strcmp(out, b) == 0);
+        assert(equalState(sa, sb) == (strcmp(a, b) == 0));
+        assert(equalState(sa, sa));
+
+        // tiles
+        int i = rand() % n, j;
+        assert(alpha[getTile(p, sa, i)] == a[i]);
+        st = setTile(p, sa, i, getTile(p, sb, i));
+        strcpy(out, a);
+        out[i] = b[i];
+        assert(packState(p, out, &sb) && equalState(st, sb));
+
+        i = rand() % (n + 1);
+        j = i + rand() % (n + 1 - i);
+        strcpy(out, a);
+        reverseString(out, i, j);
+        assert(packState(p, out, &sb));
+        assert(equalState(reverseTiles(p, sa, i, j), sb));
+        assert(equalState(reverseTiles(p, sb, i, j), sa));
+
+        // reject, leaving the state unchanged
+        st = sa;
+        a[n] = alpha[0];
+        a[n+1] = '\0';
+        assert(!packState(p, a, &st));
+        a[n-1] = '\0';
+        assert(!packState(p, a, &st));
+        a[n-1] = alpha[0];
+        a[n] = '\0';
+        a[rand() % n] = '#';
+        assert(!packState(p, a, &st));
+        assert(equalState(st, sa));
+    }
+    destroyPacking(p);
+}
+
+int main (void) {
+    // 16 characters take 4 bits, 17 or more 5; all are printable and sorted
+    // so that code I is ALPHA[I]
+    static const char *alpha[] = {
+        "A",
+        "0123456789ABCDEF",
+        "0123456789ABCDEFG",
+        "0123456789ABCDEFGHIJKLMNOPQRSTUV",
+    };
+    static const int maxTiles[] = {32, 32, 24, 24};
+
+    srand(1);
+    for(int k = 0; k < 4; k++) {
+        for(int n = 1; n <= maxTiles[k]; n++) {
+            testPacking(alpha[k], n);
+        }
+    }
+    puts("testState: all tests passed");
+    return 0;
+}